@@ -4,6 +4,10 @@ SOURCES += \
     src/astro-output.cpp \
     src/astro-data.cpp \
     src/astro-calc.cpp \
+    src/astro-ephemeris.cpp \
+    src/astro-time.cpp \
+    src/astro-search.cpp \
+    src/astro-cache.cpp \
     src/csvreader.cpp
 
 HEADERS +=\
@@ -12,10 +16,15 @@ HEADERS +=\
     src/astro-output.h \
     src/astro-data.h \
     src/astro-calc.h \
+    src/astro-ephemeris.h \
+    src/astro-time.h \
+    src/astro-search.h \
+    src/astro-cache.h \
     include/Astroprocessor/Output \
     include/Astroprocessor/Gui \
     include/Astroprocessor/Data \
     include/Astroprocessor/Calc \
+    include/Astroprocessor/Search \
     src/csvreader.h
 
 INCLUDEPATH += ../swe
@@ -0,0 +1,159 @@
+#include "astro-cache.h"
+#include "astro-calc.h"
+
+namespace A {
+
+ChartKey :: ChartKey ( const InputData& input )
+ {
+  const QTime& t = input.GMT.time();
+  seconds     = input.GMT.date().toJulianDay() * 86400 + t.hour() * 3600 + t.minute() * 60 + t.second();
+  lon         = input.location.x() + 0.0f;   // -0 -> +0
+  lat         = input.location.y() + 0.0f;
+  houseSystem = input.houseSystem;
+  zodiac      = input.zodiac;
+  aspectSet   = input.aspectSet;
+ }
+
+bool ChartKey :: operator== ( const ChartKey& other ) const
+ {
+  return seconds     == other.seconds     &&
+         lon         == other.lon         &&
+         lat         == other.lat         &&
+         houseSystem == other.houseSystem &&
+         zodiac      == other.zodiac      &&
+         aspectSet   == other.aspectSet;
+ }
+
+uint qHash ( const ChartKey& key, uint seed )
+ {
+  union { float f; quint32 i; } lon, lat;
+  lon.f = key.lon;
+  lat.f = key.lat;
+
+  quint64 h = (quint64)key.seconds * 0x9E3779B97F4A7C15ULL;
+  h ^= ((quint64)lon.i << 32 | lat.i) + 0x7F4A7C159E3779B9ULL + (h << 6) + (h >> 2);
+  h ^= (quint64)(key.houseSystem << 16 ^ key.zodiac << 8 ^ key.aspectSet) + (h << 6) + (h >> 2);
+  return (uint)(h ^ h >> 32) ^ seed;
+ }
+
+
+ChartCache :: ChartCache ( int capacity )
+ {
+  first = last = 0;
+  this->capacity = qMax(1, capacity);
+  hits = misses = 0;
+ }
+
+ChartCache :: ~ChartCache ( )
+ {
+  clear();
+ }
+
+void ChartCache :: unlink ( Entry* e )
+ {
+  (e->prev ? e->prev->next : first) = e->next;
+  (e->next ? e->next->prev : last)  = e->prev;
+  e->prev = e->next = 0;
+ }
+
+void ChartCache :: pushFront ( Entry* e )
+ {
+  e->prev = 0;
+  e->next = first;
+  (first ? first->prev : last) = e;
+  first = e;
+ }
+
+void ChartCache :: evict ( int count )
+ {
+  while (entries.count() > count && last)
+   {
+    Entry* e = last;
+    unlink(e);
+    entries.remove(e->key);
+    delete e;
+   }
+ }
+
+bool ChartCache :: find ( const InputData& input, Horoscope& scope )
+ {
+  QMutexLocker locker(&mutex);
+  Entry* e = entries.value(ChartKey(input), 0);
+
+  if (!e)
+   {
+    misses++;
+    return false;
+   }
+
+  hits++;
+  unlink(e);
+  pushFront(e);
+  scope = e->scope;
+  scope.inputData = input;
+  return true;
+ }
+
+void ChartCache :: insert ( const InputData& input, const Horoscope& scope )
+ {
+  QMutexLocker locker(&mutex);
+  ChartKey key(input);
+  Entry* e = entries.value(key, 0);
+
+  if (e)
+    unlink(e);
+  else
+   {
+    evict(capacity - 1);
+    e = new Entry(key);
+    entries.insert(key, e);
+   }
+
+  e->scope = scope;
+  pushFront(e);
+ }
+
+Horoscope ChartCache :: calculate ( const InputData& input )
+ {
+  Horoscope scope;
+  if (!find(input, scope))
+   {
+    scope = calculateAll(input);
+    insert(input, scope);
+   }
+
+  return scope;
+ }
+
+void ChartCache :: setCapacity ( int capacity )
+ {
+  QMutexLocker locker(&mutex);
+  this->capacity = qMax(1, capacity);
+  evict(this->capacity);
+ }
+
+void ChartCache :: clear ( )
+ {
+  QMutexLocker locker(&mutex);
+  evict(0);
+  hits = misses = 0;
+ }
+
+ChartCacheStats ChartCache :: stats ( ) const
+ {
+  QMutexLocker locker(&mutex);
+  ChartCacheStats ret;
+  ret.hits     = hits;
+  ret.misses   = misses;
+  ret.count    = entries.count();
+  ret.capacity = capacity;
+  return ret;
+ }
+
+ChartCache& chartCache ( )
+ {
+  static ChartCache cache;
+  return cache;
+ }
+
+}
@@ -0,0 +1,86 @@
+#ifndef A_CACHE_H
+#define A_CACHE_H
+
+#include <QHash>
+#include <QMutex>
+#include "astro-data.h"
+
+namespace A {
+
+/* Calculated horoscopes by their input, least recently used ones evicted.
+   The key is what the calculation reads from InputData: GMT to the second
+   (julianDay() ignores milliseconds and the time spec), longitude and
+   latitude of the location (not its height), house system, zodiac and
+   aspect set. A hit returns the horoscope with the caller's inputData.
+
+   Cached horoscopes refer to the loaded data (planets, signs, aspects), so
+   clear() the cache when it is loaded again. All functions are thread safe.
+
+   There is no disk cache: a chart is calculated in ~0.1 ms, less than it
+   takes to read one from a file. */
+
+struct ChartKey
+{
+  qint64      seconds;                // since the start of the julian day 0
+  float       lon, lat;
+  HouseSystemId houseSystem;
+  ZodiacId    zodiac;
+  AspectSetId aspectSet;
+
+  ChartKey ( const InputData& input );
+  bool operator==(const ChartKey& other) const;
+};
+
+uint qHash ( const ChartKey& key, uint seed = 0 );
+
+struct ChartCacheStats
+{
+  qint64 hits, misses;
+  int    count, capacity;
+
+  double hitRate() const { return hits + misses ? (double)hits / (hits + misses) : 0; }
+};
+
+class ChartCache
+ {
+  public:
+    ChartCache ( int capacity = 1024 );
+    ~ChartCache ( );
+
+    bool      find         ( const InputData& input, Horoscope& scope );   // counts a hit or a miss
+    void      insert       ( const InputData& input, const Horoscope& scope );
+    Horoscope calculate    ( const InputData& input );                      // find() or calculateAll() and insert()
+    void      setCapacity  ( int capacity );
+    void      clear        ( );
+    ChartCacheStats stats  ( ) const;
+
+  private:
+    struct Entry
+    {
+      ChartKey  key;
+      Horoscope scope;
+      Entry*    prev;                 // towards the most recently used
+      Entry*    next;
+
+      Entry ( const ChartKey& k ) : key(k) { prev = next = 0; }
+    };
+
+    QHash<ChartKey, Entry*> entries;
+    Entry* first;                     // most recently used
+    Entry* last;
+    int    capacity;
+    qint64 hits, misses;
+    mutable QMutex mutex;
+
+    void unlink ( Entry* e );
+    void pushFront ( Entry* e );
+    void evict ( int count );
+
+    ChartCache ( const ChartCache& );
+    ChartCache& operator= ( const ChartCache& );
+ };
+
+ChartCache& chartCache ( );           // shared by the application
+
+}
+#endif // A_CACHE_H
@@ -5,21 +5,35 @@
 
 #include <math.h>
 #include "astro-calc.h"
+#include <QThreadPool>
+#include <QThreadStorage>
+#include <QSemaphore>
+#include <QAtomicInt>
+#include <QThread>
+#include <QMutex>
+#include <QHash>
+#include <QtAlgorithms>
 #include <QDebug>
 
 namespace A {
 
-double getJulianDate ( QDateTime GMT )
+
+/* Swiss Ephemeris keeps its state (open files, cached segments) per thread,
+   see TLS in sweodef.h. Every thread that calculates gets its own context,
+   which sets the ephemeris path and closes the files when the thread ends. */
+
+class EphemerisContext
  {
-  int m     = GMT.date().month();
-  int y     = GMT.date().year();
-  int d     = GMT.date().day();
-  double ut = GMT.time().hour()
-            + GMT.time().minute() * 1.0 / 60
-            + GMT.time().second() * 1.0 / 3600;
+  public:
+    EphemerisContext()  { swe_set_ephe_path( "swe/" ); }
+    ~EphemerisContext() { swe_close(); }
+ };
 
-  if (m <= 2) { m = m + 12; y = y - 1; }
-  return (int)(365.25*(y+4716)) + (int)(30.6001*(m+1)) + d - 13 - 1524.5 + (double)ut/24.0;
+void attachEphemeris ( )
+ {
+  static QThreadStorage<EphemerisContext*> context;
+  if (!context.hasLocalData())
+    context.setLocalData(new EphemerisContext);
  }
 
 float roundDegree  ( float deg )
@@ -104,6 +118,14 @@ AspectId aspect ( const Planet& planet, QPointF coordinate, const AspectsSet& as
 
 AspectId aspect ( float angle, const AspectsSet& aspectSet )
  {
+  const QVector<signed char>& lookup = aspectSet.lookup;
+  if (angle >= 0 && !lookup.isEmpty())
+   {
+    int i = (int)(angle * Aspect_LookupScale);
+    if (i >= lookup.count()) return Aspect_None;    // beyond all orbs
+    if (lookup[i] != Aspect_LookupScan) return lookup[i];
+   }
+
   foreach ( const AspectType& aspect, aspectSet.aspects )
    {
     //if (aspect.id == Aspect_None) qDebug() << "aaa!";
@@ -248,22 +270,73 @@ PlanetId receptionWith   ( const Planet& planet, const Horoscope& scope )
 
 
 
-Planet calculatePlanet ( PlanetId planet, const InputData& input, const Houses& houses, const Zodiac& zodiac )
+// ecliptic coordinates and speeds of a body at jd (UT) = tt (TT), xx as swe_calc_ut
+static bool eclipticPosition ( const Planet& p, double jd, double tt, double* xx )
  {
-  Planet ret = getPlanet(planet);
-
-  uint    invertPositionFlag = 256 * 1024;
-  double  jd = getJulianDate(input.GMT);
-  char    errStr[256] = "";
-  double  xx[6];
+  char errStr[256] = "";
+  int  flags = p.sweFlags & ~Planet_InvertPosition;
 
   // TODO: wrong moon speed calculation
   // (flags: SEFLG_TRUEPOS|SEFLG_SPEED = 272)
   //         272|invertPositionFlag = 262416
-  qDebug( "A:  '%s' at julian day %f: %s", qPrintable(ret.name), jd, errStr );
-  if (swe_calc_ut( jd, ret.sweNum, ret.sweFlags, xx, errStr ) >= 0)
+  if (chartPosition( p.sweNum, flags, jd, xx ) ||
+      swe_calc( tt, p.sweNum, flags, xx, errStr ) >= 0)
+    return true;
+
+  qDebug( "A: can't calculate position of '%s' at julian day %f: %s", qPrintable(p.name), jd, errStr );
+  return false;
+ }
+
+/* Horizontal coordinates as swe_azalt(SE_ECL2HOR) gives them, with the
+   sidereal time, ARMC and obliquity found once for all bodies of a chart
+   instead of once per body. The houses are calculated from the same ARMC
+   and obliquity, as swe_houses_ex() does. */
+
+struct HorizontalFrame
+{
+  double armc;                         // degrees
+  double eps;                          // true obliquity of the ecliptic
+  double colatitude;
+};
+
+static void horizontalFrame ( double jd, double tt, const InputData& input, HorizontalFrame& frame )
+ {
+  double x[6];
+  swe_calc( tt, SE_ECL_NUT, 0, x, NULL );                    // true obliquity, nutation in longitude
+
+  frame.armc       = swe_degnorm( swe_sidtime0(jd, x[0], x[2]) * 15 + input.location.x() );
+  frame.eps        = x[0];
+  frame.colatitude = 90 - (double)input.location.y();
+ }
+
+static void horizontalPosition ( const HorizontalFrame& frame, const double* xx, double* hor )
+ {
+  double x[3] = { xx[0], xx[1], 1 };
+
+  swe_cotrans( x, x, -frame.eps );                           // equatorial
+  x[0] = swe_degnorm( swe_degnorm(x[0] - frame.armc) - 90 );
+  swe_cotrans( x, x, frame.colatitude );                     // azimuth from east, counterclock
+  hor[0] = 360 - swe_degnorm(x[0] + 90);                     // azimuth from south to west
+  hor[1] = x[1];                                             // true height
+ }
+
+Planet calculatePlanet ( PlanetId planet, const InputData& input, const Houses& houses, const Zodiac& zodiac )
+ {
+  attachEphemeris();
+  Planet ret = getPlanet(planet);
+
+  double  jd = julianDay(input.GMT);
+  double  tt = terrestrialTime(jd);
+  double  xx[6], hor[2];
+
+  qDebug( "A:  '%s' at julian day %f", qPrintable(ret.name), jd );
+  if (eclipticPosition( ret, jd, tt, xx ))
    {
-    if (!(ret.sweFlags & invertPositionFlag))
+    HorizontalFrame frame;
+    horizontalFrame(jd, tt, input, frame);
+    horizontalPosition(frame, xx, hor);
+
+    if (!(ret.sweFlags & Planet_InvertPosition))
       ret.eclipticPos.setX ( xx[0] );
     else                               // found 'inverted position' flag
       ret.eclipticPos.setX ( roundDegree(xx[0]-180) );
@@ -272,20 +345,9 @@ Planet calculatePlanet ( PlanetId planet, const InputData& input, const Houses&
     ret.distance = xx[2];
     ret.eclipticSpeed.setX( xx[3] );
     ret.eclipticSpeed.setY( xx[4] );
-
-    double geopos[3];                  // calculate horizontal coordinates
-    double hor[3];
-    geopos[0] = input.location.x();
-    geopos[1] = input.location.y();
-    geopos[2] = input.location.z();
-    swe_azalt( jd, SE_ECL2HOR, geopos, 0,0, xx, hor);
     ret.horizontalPos.setX(hor[0]);
     ret.horizontalPos.setY(hor[1]);
    }
-  else
-   {
-    qDebug( "A: can't calculate position of '%s' at julian day %f: %s", qPrintable(ret.name), jd, errStr );
-   }
 
 
   ret.sign          = &getSign(ret.eclipticPos.x(), zodiac);
@@ -297,16 +359,14 @@ Planet calculatePlanet ( PlanetId planet, const InputData& input, const Houses&
   return ret;
  }
 
-Houses calculateHouses ( const InputData& input )
+static Houses calculateHouses ( const HorizontalFrame& frame, const InputData& input )
  {
   Houses ret;
   ret.system = &getHouseSystem(input.houseSystem);
 
-  double julianDay = getJulianDate(input.GMT);
   double hcusps[14], ascmc[11];
-
-  swe_houses_ex( julianDay, 0, input.location.y(), input.location.x(),
-                  ret.system->sweCode, hcusps, ascmc );
+  swe_houses_armc( frame.armc, input.location.y(), frame.eps,
+                   ret.system->sweCode, hcusps, ascmc );
 
   for (int i = 0; i < 12; i++)
     ret.cusp[i] = hcusps[i+1];
@@ -314,9 +374,60 @@ Houses calculateHouses ( const InputData& input )
   return ret;
  }
 
-PlanetPower calculatePlanetPower ( const Planet& planet, const Horoscope& scope )
+Houses calculateHouses ( const InputData& input )
+ {
+  attachEphemeris();
+  double jd = julianDay(input.GMT);
+
+  HorizontalFrame frame;
+  horizontalFrame(jd, terrestrialTime(jd), input, frame);
+  return calculateHouses(frame, input);
+ }
+
+/* Chart slots: the same rules as the functions above taking Planet, on the
+   flat arrays of ChartData */
+
+static float chartAngle ( const ChartData& chart, int i, double lon, double lat )
+ {
+  float a = angle(chart.lon[i], lon);
+  float b = angle(chart.lat[i], lat);
+  return sqrt(pow(a, 2) + pow(b, 2));
+ }
+
+static AspectId chartAspect ( const ChartData& chart, int i, int j, const AspectsSet& aspectSet )
+ {
+  if (j < 0 || chart.planet[i]->sweNum == chart.planet[j]->sweNum)
+    return Aspect_None;
+
+  return aspect(chartAngle(chart, i, chart.lon[j], chart.lat[j]), aspectSet);
+ }
+
+static bool chartEarlier ( const ChartData& chart, int i, int j )
+ {
+  return (roundDegree(chart.lon[i] - chart.lon[j]) > 180);
+ }
+
+static bool chartReception ( const ChartData& chart, int i )
+ {
+  for (int j = 0; j < chart.count; j++)
+   {
+    if (j == i) continue;
+
+    PlanetPosition a = getPosition(*chart.planet[j], chart.sign[i]->id);
+    PlanetPosition b = getPosition(*chart.planet[i], chart.sign[j]->id);
+    if ((a == Position_Dwelling   && b == Position_Dwelling) ||
+        (a == Position_Exaltation && b == Position_Exaltation)) return true;
+   }
+
+  return false;
+ }
+
+static PlanetPower calculatePower ( const ChartData& chart, int i )
  {
   PlanetPower ret;
+  const Planet& planet = *chart.planet[i];
+  int sun = chart.indexOf(Planet_Sun);
+  float speed = chart.lonSpeed[i];
 
   // TODO: does this shit works properly at all?
 
@@ -324,7 +435,7 @@ PlanetPower calculatePlanetPower ( const Planet& planet, const Horoscope& scope
 
 
   bool peregrine = false;
-  switch (planet.position)
+  switch (chart.position[i])
    {
     case Position_Dwelling:
     case Position_Exaltation: ret.dignity   += 5; break;
@@ -334,13 +445,13 @@ PlanetPower calculatePlanetPower ( const Planet& planet, const Horoscope& scope
     default: break;
    }
 
-  if (receptionWith(planet, scope) != Planet_None)
+  if (chartReception(chart, i))
     ret.dignity += 5;
   else if (peregrine)
     ret.deficient -= 5;
 
 
-  switch (planet.house)
+  switch (chart.house[i])
    {
     case 1: case 10:         ret.dignity   += 5; break;
     case 4: case 7: case 11: ret.dignity   += 4; break;
@@ -352,47 +463,53 @@ PlanetPower calculatePlanetPower ( const Planet& planet, const Horoscope& scope
     default: break;
    }
 
-  if (planet.eclipticSpeed.x() > 0 &&
+  if (speed > 0 &&
       planet.id != Planet_Sun &&
       planet.id != Planet_Moon)
     ret.dignity += 4;
 
-  if (planet.eclipticSpeed.x() > planet.defaultEclipticSpeed.x())
+  if (speed > planet.defaultEclipticSpeed.x())
     ret.dignity += 2;
-  else if (planet.eclipticSpeed.x() > 0)
+  else if (speed > 0)
     ret.deficient -= 2;
   else
     ret.deficient -= 5;
 
-  switch (planet.id)
-   {
-    case Planet_Mars:
-    case Planet_Jupiter:
-    case Planet_Saturn:   if (isEarlier(planet, scope.sun))
-                            ret.dignity += 2;
-                          else
-                            ret.deficient -= 2; break;
-    case Planet_Mercury:
-    case Planet_Venus:
-    case Planet_Moon :    if (!isEarlier(planet, scope.sun))
-                            ret.dignity += 2;
-                          else
-                            ret.deficient -= 2; break;
-    default: break;
-   }
-
-  if (planet.id != Planet_Sun)
+  if (sun >= 0)
    {
-    if      ( angle(planet, scope.sun) > 9 ) // not burned by sun
-      ret.dignity += 5;
-    else if ( angle(planet, scope.sun) < 0.4 ) // 'in cazimo'
-      ret.dignity += 5;
-    else // burned by sun
-      ret.deficient -= 4;
+    switch (planet.id)
+     {
+      case Planet_Mars:
+      case Planet_Jupiter:
+      case Planet_Saturn:   if (chartEarlier(chart, i, sun))
+                              ret.dignity += 2;
+                            else
+                              ret.deficient -= 2; break;
+      case Planet_Mercury:
+      case Planet_Venus:
+      case Planet_Moon :    if (!chartEarlier(chart, i, sun))
+                              ret.dignity += 2;
+                            else
+                              ret.deficient -= 2; break;
+      default: break;
+     }
+
+    if (planet.id != Planet_Sun)
+     {
+      float a = chartAngle(chart, i, chart.lon[sun], chart.lat[sun]);
+      if      ( a > 9 )                // not burned by sun
+        ret.dignity += 5;
+      else if ( a < 0.4 )              // 'in cazimo'
+        ret.dignity += 5;
+      else                             // burned by sun
+        ret.deficient -= 4;
+     }
    }
 
 
-  switch (aspect(planet, scope.jupiter, topAspectSet()))
+  const AspectsSet& top = topAspectSet();
+
+  switch (chartAspect(chart, i, chart.indexOf(Planet_Jupiter), top))
    {
     case Aspect_Conjunction: ret.dignity += 5; break;
     case Aspect_Trine:       ret.dignity += 4; break;
@@ -400,7 +517,7 @@ PlanetPower calculatePlanetPower ( const Planet& planet, const Horoscope& scope
     default: break;
    }
 
-  switch (aspect(planet, scope.venus, topAspectSet()))
+  switch (chartAspect(chart, i, chart.indexOf(Planet_Venus), top))
    {
     case Aspect_Conjunction: ret.dignity += 5; break;
     case Aspect_Trine:       ret.dignity += 4; break;
@@ -408,7 +525,7 @@ PlanetPower calculatePlanetPower ( const Planet& planet, const Horoscope& scope
     default: break;
    }
 
-  switch (aspect(planet, scope.northNode, topAspectSet()))
+  switch (chartAspect(chart, i, chart.indexOf(Planet_NorthNode), top))
    {
     case Aspect_Conjunction:
     /*case Aspect_Trine:
@@ -417,7 +534,7 @@ PlanetPower calculatePlanetPower ( const Planet& planet, const Horoscope& scope
     default: break;
    }
 
-  switch (aspect(planet, scope.mars, topAspectSet()))
+  switch (chartAspect(chart, i, chart.indexOf(Planet_Mars), top))
    {
     case Aspect_Conjunction: ret.deficient -= 5; break;
     case Aspect_Opposition:  ret.deficient -= 4; break;
@@ -425,7 +542,7 @@ PlanetPower calculatePlanetPower ( const Planet& planet, const Horoscope& scope
     default: break;
    }
 
-  switch (aspect(planet, scope.saturn, topAspectSet()))
+  switch (chartAspect(chart, i, chart.indexOf(Planet_Saturn), top))
    {
     case Aspect_Conjunction: ret.deficient -= 5; break;
     case Aspect_Opposition:  ret.deficient -= 4; break;
@@ -434,16 +551,29 @@ PlanetPower calculatePlanetPower ( const Planet& planet, const Horoscope& scope
    }
 
 
-  if (aspect(planet, QPointF(149.833, 0.45), topAspectSet()) == Aspect_Conjunction)
-    ret.dignity += 6;                  // Regulus coordinates at 2000year: 29LEO50, +00.27'
+  for (int k = 0; k < chart.starConjunctionCount; k++)
+   {
+    const ChartStarConjunction& c = chart.starConjunctions[k];
+    if (c.planet != i) continue;
+
+    int power = getStars()[c.star].power;         // stars.csv: Regulus +6, Spica +5, Algol -5...
+    if (power > 0)
+      ret.dignity += power;
+    else
+      ret.deficient += power;
+   }
 
-  if (aspect(planet, QPointF(203.833, -2.05), topAspectSet()) == Aspect_Conjunction)
-    ret.dignity += 5;                  // Spica coordinates at 2000year: 23LIB50, -02.03'
+  return ret;
+ }
 
-  if (aspect(planet, QPointF(56.166, 22.416), topAspectSet()) == Aspect_Conjunction)
-    ret.deficient -= 5;                // Algol coordinates at 2000year: 26TAU10, +22.25'
+PlanetPower calculatePlanetPower ( const Planet& planet, const Horoscope& scope )
+ {
+  ChartData chart;
+  toChart(scope, chart);
 
-  return ret;
+  int i = chart.indexOf(planet.id);
+  if (i < 0) return PlanetPower();
+  return calculatePower(chart, i);
  }
 
 Aspect calculateAspect ( const AspectsSet& aspectSet, const Planet& planet1, const Planet& planet2 )
@@ -500,34 +630,541 @@ AspectList calculateAspects ( const AspectsSet& aspectSet, const PlanetMap& plan
   return ret;
  }
 
-Horoscope calculateAll ( const InputData& input )
+/* Evaluation plan of a chart: a body is calculated by swe only if no
+   earlier slot needs the same call (sweNum and flags without the invert
+   flag); otherwise it is derived from that slot. So S. Pole is the true
+   node turned by 180 degrees, without a second swe_calc_ut. */
+
+static int evaluationSource ( const ChartData& chart, int i )
+ {
+  int num   = chart.planet[i]->sweNum;
+  int flags = chart.planet[i]->sweFlags & ~Planet_InvertPosition;
+
+  for (int j = 0; j < i; j++)
+    if (chart.planet[j]->sweNum == num &&
+        (chart.planet[j]->sweFlags & ~Planet_InvertPosition) == flags)
+      return j;
+
+  return -1;
+ }
+
+static void calculateChartPlanets ( ChartData& chart, const HorizontalFrame& frame )
+ {
+  double xx[Chart_MaxPlanets][6];
+  double hor[Chart_MaxPlanets][2];
+
+  for (int i = 0; i < chart.count; i++)
+   {
+    const Planet& p = *chart.planet[i];
+    int source = evaluationSource(chart, i);
+
+    if (source >= 0)
+     {
+      for (int k = 0; k < 6; k++) xx[i][k] = xx[source][k];
+      hor[i][0] = hor[source][0];
+      hor[i][1] = hor[source][1];
+     }
+    else if (eclipticPosition(p, chart.jd, chart.tt, xx[i]))
+      horizontalPosition(frame, xx[i], hor[i]);
+    else
+     {
+      for (int k = 0; k < 6; k++) xx[i][k] = 0;
+      hor[i][0] = hor[i][1] = 0;
+     }
+
+    chart.lon[i]      = xx[i][0];
+    chart.lat[i]      = xx[i][1];
+    chart.distance[i] = xx[i][2];
+    chart.lonSpeed[i] = xx[i][3];
+    chart.latSpeed[i] = xx[i][4];
+    chart.azimuth[i]  = hor[i][0];
+    chart.altitude[i] = hor[i][1];
+
+    if (p.sweFlags & Planet_InvertPosition)
+      chart.lon[i] = roundDegree(chart.lon[i] - 180);
+   }
+ }
+
+// horizontal coordinates for a new location; ecliptic positions are geocentric
+// and stay. Inverted bodies have the coordinates of their source, as above.
+static void calculateChartHorizontal ( ChartData& chart, const HorizontalFrame& frame )
+ {
+  for (int i = 0; i < chart.count; i++)
+   {
+    int source = evaluationSource(chart, i);
+    double hor[2];
+
+    if (source >= 0)
+     {
+      chart.azimuth[i]  = chart.azimuth[source];
+      chart.altitude[i] = chart.altitude[source];
+      continue;
+     }
+
+    double xx[2] = { chart.lon[i], chart.lat[i] };
+    if (chart.planet[i]->sweFlags & Planet_InvertPosition)
+      xx[0] = roundDegree(xx[0] + 180);
+
+    horizontalPosition(frame, xx, hor);
+    chart.azimuth[i]  = hor[0];
+    chart.altitude[i] = hor[1];
+   }
+ }
+
+/* Stars at an epoch: J2000 positions moved by their proper motion and
+   precessed to the ecliptic of date (Meeus, Astronomical Algorithms, 21.5),
+   sorted by longitude. Charts of one year share them: precession moves
+   stars by 50" a year, nutation and aberration (left out) by less than 40",
+   all far within any orb. */
+
+struct StarPlace
+{
+  float lon, lat;
+  int   star;                          // index in getStars()
+};
+
+static bool lonLess ( const StarPlace& a, const StarPlace& b ) { return a.lon < b.lon; }
+
+static QVector<StarPlace> precessStars ( double t )   // julian centuries since J2000
+ {
+  const double deg = M_PI / 180;
+  double eta = (47.0029 - (0.03302 - 0.000060 * t) * t) * t / 3600 * deg;
+  double pi  = 174.876384 - (869.8089 - 0.03536 * t) * t / 3600;
+  double p   = (5029.0966 + (1.11113 - 0.000006 * t) * t) * t / 3600;
+
+  const QVector<Star>& stars = getStars();
+  QVector<StarPlace> ret(stars.count());
+
+  for (int i = 0; i < stars.count(); i++)
+   {
+    const Star& s = stars[i];
+    double lon = (s.eclipticPos.x() + s.eclipticSpeed.x() * t) * deg;
+    double lat = (s.eclipticPos.y() + s.eclipticSpeed.y() * t) * deg;
+    double a = pi * deg - lon;
+
+    double x = cos(eta) * cos(lat) * sin(a) - sin(eta) * sin(lat);
+    double y = cos(lat) * cos(a);
+    double z = cos(eta) * sin(lat) + sin(eta) * cos(lat) * sin(a);
+
+    ret[i].lon  = roundDegree(p + pi - atan2(x, y) / deg);
+    ret[i].lat  = asin(z) / deg;
+    ret[i].star = i;
+   }
+
+  qSort(ret.begin(), ret.end(), lonLess);
+  return ret;
+ }
+
+static QVector<StarPlace> starsOfYear ( double jd )
+ {
+  static QMutex mutex;
+  static QHash<int, QVector<StarPlace> > years;  // ~12 kB each, shared by all threads
+  int year = floor((jd - 2451545.0) / 365.25);
+
+  QMutexLocker locker(&mutex);
+  QHash<int, QVector<StarPlace> >::const_iterator i = years.constFind(year);
+  if (i != years.constEnd())
+    return i.value();
+
+  if (years.count() >= 512) years.clear();
+  QVector<StarPlace> ret = precessStars((year + 0.5) / 100);
+  years.insert(year, ret);
+  return ret;
+ }
+
+// conjunctions of the bodies with all stars of the catalog, with the
+// conjunction of the top aspect set: stars close in longitude are found by
+// a binary search of the body's longitude, not by trying all of them.
+// A body can't take the slots of the bodies after it: one with more
+// conjunctions than its share only loses its own (and says so)
+static void calculateChartStars ( ChartData& chart )
+ {
+  chart.starConjunctionCount = 0;
+
+  const AspectsSet& top = topAspectSet();
+  QMap<AspectId, AspectType>::const_iterator c = top.aspects.constFind(Aspect_Conjunction);
+  if (c == top.aspects.constEnd()) return;
+  float orb = c.value().angle + c.value().orb;         // the widest angle in conjunction
+
+  QVector<StarPlace> stars = starsOfYear(chart.jd);
+  const StarPlace* begin = stars.constData();
+  const StarPlace* end   = begin + stars.count();
+  if (begin == end) return;
+
+  for (int i = 0; i < chart.count; i++)
+   {
+    int first = chart.starConjunctionCount;         // each body left gets an equal share of the free slots
+    int last  = first + (Chart_MaxStarConjunctions - first) / (chart.count - i);
+
+    StarPlace from;
+    from.lon = roundDegree(chart.lon[i] - orb);
+    const StarPlace* s = qLowerBound(begin, end, from, lonLess);
+
+    for (int k = 0; k < stars.count(); k++, s++)      // stars in [lon - orb, lon + orb], past 360 too
+     {
+      if (s == end) s = begin;
+      if (roundDegree(s->lon - from.lon) > 2 * orb) break;
+
+      float a = chartAngle(chart, i, s->lon, s->lat);
+      if (aspect(a, top) != Aspect_Conjunction) continue;
+      if (chart.starConjunctionCount == last)
+       {
+        qDebug( "A: '%s' has more than %d star conjunctions at julian day %f, the ones from %f dropped",
+                qPrintable(chart.planet[i]->name), last - first, chart.jd, s->lon );
+        break;
+       }
+
+      ChartStarConjunction& c = chart.starConjunctions[chart.starConjunctionCount++];
+      c.planet = i;
+      c.star   = s->star;
+      c.orb    = a;
+     }
+   }
+ }
+
+// signs, houses and dignities from the positions, houses and zodiac of the chart
+static void calculateChartPlacement ( ChartData& chart )
+ {
+  for (int i = 0; i < chart.count; i++)
+   {
+    const Planet& p = *chart.planet[i];
+    chart.sign[i]       = &getSign(chart.lon[i], *chart.zodiac);
+    chart.house[i]      = getHouse(chart.houses, chart.lon[i]);
+    chart.position[i]   = getPosition(p, chart.sign[i]->id);
+    chart.houseRuler[i] = p.homeSigns.count() ? getHouse(p.homeSigns.first(), chart.houses, *chart.zodiac) : 0;
+   }
+
+  for (int i = 0; i < chart.count; i++)
+    chart.power[i] = calculatePower(chart, i);
+ }
+
+// angles from slot i to the slots after it, as angle(Planet, Planet) gives
+// them. 180 - |180 - a| folds a (0... 360) without a branch and, as it is
+// exact in double, rounds to the same float as 360 - a; so the first loop
+// gets vectorized (-O3). sqrt stays out of it, since it may set errno.
+static void pairAngles ( const float* lon, const float* lat, int i, int count, float* angles )
+ {
+  double squares[Chart_MaxPlanets];
+
+  for (int j = i + 1; j < count; j++)
+   {
+    float a = 180 - fabs(180 - fabs((double)(lon[i] - lon[j])));
+    float b = 180 - fabs(180 - fabs((double)(lat[i] - lat[j])));
+    squares[j] = (double)a * a + (double)b * b;
+   }
+
+  for (int j = i + 1; j < count; j++)
+    angles[j] = sqrt(squares[j]);
+ }
+
+static void calculateChartAspects ( ChartData& chart )
+ {
+  const AspectsSet& set = *chart.aspectSet;
+  float lon[Chart_MaxPlanets], lat[Chart_MaxPlanets], angles[Chart_MaxPlanets];
+  chart.aspectCount = 0;
+
+  for (int i = 0; i < chart.count; i++)
+   {
+    lon[i] = chart.lon[i];
+    lat[i] = chart.lat[i];
+   }
+
+  for (int i = 0; i < chart.count; i++)
+   {
+    pairAngles(lon, lat, i, chart.count, angles);
+
+    for (int j = i + 1; j < chart.count; j++)
+     {
+      if (chart.planet[i]->sweNum == chart.planet[j]->sweNum) continue;
+
+      float angle = angles[j];
+      AspectId id = aspect(angle, set);
+      if (id == Aspect_None) continue;
+
+      ChartAspect& a = chart.aspects[chart.aspectCount++];
+      a.d        = &set.aspects.constFind(id).value();
+      a.planet1  = i;
+      a.planet2  = j;
+      a.angle    = angle;
+      a.orb      = qAbs(a.d->angle - angle);
+
+      int p1 = i, p2 = j;              // make first planet earlier than second
+      if (!chartEarlier(chart, i, j)) { p1 = j; p2 = i; }
+      a.applying = (chart.lonSpeed[p1] > chart.lonSpeed[p2]) == (angle > a.d->angle);
+     }
+   }
+ }
+
+void calculateChart ( const InputData& input, ChartData& chart )
+ {
+  attachEphemeris();
+  chart.jd        = julianDay(input.GMT);
+  chart.tt        = terrestrialTime(chart.jd);
+
+  HorizontalFrame frame;
+  horizontalFrame(chart.jd, chart.tt, input, frame);
+  chart.houses    = calculateHouses(frame, input);
+  chart.zodiac    = &getZodiac(input.zodiac);
+  chart.aspectSet = &getAspectSet(input.aspectSet);
+  chart.count     = 0;
+
+  const PlanetMap& planets = getPlanetMap();
+  PlanetMap::const_iterator i = planets.constBegin();
+  while (i != planets.constEnd() && chart.count < Chart_MaxPlanets)
+   {
+    chart.planet[chart.count++] = &i.value();
+    ++i;
+   }
+
+  calculateChartPlanets(chart, frame);
+  calculateChartStars(chart);
+  calculateChartPlacement(chart);
+  calculateChartAspects(chart);
+ }
+
+/* Stages of a chart and what they depend on:
+     ecliptic positions   GMT
+     horizontal           GMT, location
+     star conjunctions    positions (top aspect set)
+     houses               GMT, location, house system
+     signs, houses, power positions, houses, zodiac (power: top aspect set, star conjunctions)
+     aspects              positions, aspect set */
+
+void recalculateChart ( const InputData& input, ChartData& chart, int changes )
+ {
+  if (changes & Change_GMT)
+   {
+    calculateChart(input, chart);
+    return;
+   }
+
+  attachEphemeris();
+  if (changes & (Change_Location | Change_HouseSystem))
+   {
+    HorizontalFrame frame;
+    horizontalFrame(chart.jd, chart.tt, input, frame);
+    chart.houses = calculateHouses(frame, input);
+    if (changes & Change_Location)
+      calculateChartHorizontal(chart, frame);
+   }
+
+  if (changes & (Change_Location | Change_HouseSystem | Change_Zodiac))
+   {
+    chart.zodiac = &getZodiac(input.zodiac);
+    calculateChartPlacement(chart);
+   }
+
+  if (changes & Change_AspectSet)
+   {
+    chart.aspectSet = &getAspectSet(input.aspectSet);
+    calculateChartAspects(chart);
+   }
+ }
+
+void toChart ( const Horoscope& scope, ChartData& chart )
+ {
+  chart.jd        = julianDay(scope.inputData.GMT);
+  chart.tt        = terrestrialTime(chart.jd);
+  chart.houses    = scope.houses;
+  chart.zodiac    = &scope.zodiac;
+  chart.aspectSet = &getAspectSet(scope.inputData.aspectSet);
+  chart.count     = 0;
+
+  foreach (const Planet& p, scope.planets)
+   {
+    if (chart.count == Chart_MaxPlanets) break;
+
+    int i = chart.count++;
+    chart.planet[i]     = &p;
+    chart.lon[i]        = p.eclipticPos.x();
+    chart.lat[i]        = p.eclipticPos.y();
+    chart.lonSpeed[i]   = p.eclipticSpeed.x();
+    chart.latSpeed[i]   = p.eclipticSpeed.y();
+    chart.distance[i]   = p.distance;
+    chart.azimuth[i]    = p.horizontalPos.x();
+    chart.altitude[i]   = p.horizontalPos.y();
+    chart.sign[i]       = p.sign ? p.sign : &getSign(p.eclipticPos.x(), scope.zodiac);
+    chart.house[i]      = p.house;
+    chart.houseRuler[i] = p.houseRuler;
+    chart.position[i]   = p.position;
+    chart.power[i]      = p.power;
+   }
+
+  chart.aspectCount = 0;
+  foreach (const Aspect& a, scope.aspects)
+   {
+    int i = a.planet1 ? chart.indexOf(a.planet1->id) : -1;
+    int j = a.planet2 ? chart.indexOf(a.planet2->id) : -1;
+    if (i < 0 || j < 0 || chart.aspectCount == Chart_MaxAspects) continue;
+
+    ChartAspect& c = chart.aspects[chart.aspectCount++];
+    c.d        = a.d;
+    c.planet1  = i;
+    c.planet2  = j;
+    c.angle    = a.angle;
+    c.orb      = a.orb;
+    c.applying = a.applying;
+   }
+
+  chart.starConjunctionCount = 0;
+  const Star* stars = getStars().constData();
+  foreach (const StarConjunction& s, scope.starConjunctions)
+   {
+    int i = chart.indexOf(s.planet);
+    if (i < 0 || !s.star || chart.starConjunctionCount == Chart_MaxStarConjunctions) continue;
+
+    ChartStarConjunction& c = chart.starConjunctions[chart.starConjunctionCount++];
+    c.planet = i;
+    c.star   = s.star - stars;
+    c.orb    = s.orb;
+   }
+ }
+
+Horoscope toHoroscope ( const ChartData& chart, const InputData& input )
  {
   Horoscope scope;
   scope.inputData = input;
-  scope.houses = calculateHouses(input);
-  scope.zodiac = getZodiac(input.zodiac);
-
-  foreach (PlanetId id, getPlanets())
-    scope.planets[id] = calculatePlanet(id, input, scope.houses, scope.zodiac);
+  scope.houses    = chart.houses;
+  scope.zodiac    = *chart.zodiac;
 
-  scope.sun        = scope.planets[Planet_Sun];
-  scope.moon       = scope.planets[Planet_Moon];
-  scope.mercury    = scope.planets[Planet_Mercury];
-  scope.venus      = scope.planets[Planet_Venus];
-  scope.mars       = scope.planets[Planet_Mars];
-  scope.jupiter    = scope.planets[Planet_Jupiter];
-  scope.saturn     = scope.planets[Planet_Saturn];
-  scope.uranus     = scope.planets[Planet_Uranus];
-  scope.neptune    = scope.planets[Planet_Neptune];
-  scope.pluto      = scope.planets[Planet_Pluto];
-  scope.northNode  = scope.planets[Planet_NorthNode];
+  for (int i = 0; i < chart.count; i++)
+   {
+    Planet& p = scope.planets[chart.planet[i]->id];
+    p = *chart.planet[i];
+    p.eclipticPos   = QPointF(chart.lon[i], chart.lat[i]);
+    p.eclipticSpeed = QVector2D(chart.lonSpeed[i], chart.latSpeed[i]);
+    p.horizontalPos = QPointF(chart.azimuth[i], chart.altitude[i]);
+    p.distance      = chart.distance[i];
+    p.sign          = chart.sign[i];
+    p.house         = chart.house[i];
+    p.houseRuler    = chart.houseRuler[i];
+    p.position      = (PlanetPosition)chart.position[i];
+    p.power         = chart.power[i];
+   }
 
-  foreach (PlanetId id, scope.planets.keys())
-    scope.planets[id].power = calculatePlanetPower(scope.planets[id], scope);
+  scope.sun        = scope.planets.value(Planet_Sun);
+  scope.moon       = scope.planets.value(Planet_Moon);
+  scope.mercury    = scope.planets.value(Planet_Mercury);
+  scope.venus      = scope.planets.value(Planet_Venus);
+  scope.mars       = scope.planets.value(Planet_Mars);
+  scope.jupiter    = scope.planets.value(Planet_Jupiter);
+  scope.saturn     = scope.planets.value(Planet_Saturn);
+  scope.uranus     = scope.planets.value(Planet_Uranus);
+  scope.neptune    = scope.planets.value(Planet_Neptune);
+  scope.pluto      = scope.planets.value(Planet_Pluto);
+  scope.northNode  = scope.planets.value(Planet_NorthNode);
+
+  for (int i = 0; i < chart.aspectCount; i++)
+   {
+    const ChartAspect& c = chart.aspects[i];
+    Aspect a;
+    a.d        = c.d;
+    a.planet1  = &scope.planets[chart.planet[c.planet1]->id];
+    a.planet2  = &scope.planets[chart.planet[c.planet2]->id];
+    a.angle    = c.angle;
+    a.orb      = c.orb;
+    a.applying = c.applying;
+    scope.aspects << a;
+   }
 
-  scope.aspects = calculateAspects(getAspectSet(input.aspectSet), scope.planets);
+  for (int i = 0; i < chart.starConjunctionCount; i++)
+   {
+    const ChartStarConjunction& c = chart.starConjunctions[i];
+    StarConjunction s;
+    s.star   = &getStars()[c.star];
+    s.planet = chart.planet[c.planet]->id;
+    s.orb    = c.orb;
+    scope.starConjunctions << s;
+   }
 
   return scope;
  }
 
+Horoscope calculateAll ( const InputData& input )
+ {
+  ChartData chart;
+  calculateChart(input, chart);
+  return toHoroscope(chart, input);
+ }
+
+Horoscope recalculateAll ( const Horoscope& scope, const InputData& input, int changes )
+ {
+  if ((changes & Change_GMT) || scope.planets.isEmpty())
+    return calculateAll(input);
+
+  ChartData chart;
+  toChart(scope, chart);
+  recalculateChart(input, chart, changes);
+  return toHoroscope(chart, input);
+ }
+
+
+template <class T> class CalculateTask : public QRunnable
+ {
+  typedef void (*Calculate) ( const InputData& input, T& output );
+
+  Calculate calculate;
+  const QList<InputData>& inputs;
+  T* output;
+  QAtomicInt& next;
+  QSemaphore& done;
+
+  public:
+    CalculateTask ( Calculate f, const QList<InputData>& in, T* out, QAtomicInt& n, QSemaphore& d )
+      : calculate(f), inputs(in), output(out), next(n), done(d) { }
+
+    void run()
+     {
+      int i;
+      while ((i = next.fetchAndAddRelaxed(1)) < inputs.count())
+        calculate(inputs[i], output[i]);
+      done.release();
+     }
+ };
+
+static QThreadPool* createCalculationPool()
+ {
+  QThreadPool* pool = new QThreadPool;
+  pool->setExpiryTimeout(-1);          // keep workers, so their ephemeris files stay open
+  return pool;
+ }
+
+static QThreadPool* calculationPool()
+ {
+  static QThreadPool* pool = createCalculationPool();   // one pool for all kinds of tasks
+  return pool;
+ }
+
+// spreads inputs over all cores, output[i] is calculated from inputs[i]
+template <class T> static void calculateParallel ( void (*calculate)(const InputData&, T&),
+                                                   const QList<InputData>& inputs, T* output )
+ {
+  QThreadPool* pool = calculationPool();
+  QAtomicInt next(0);
+  QSemaphore done;
+  int workers = qBound(1, qMin(pool->maxThreadCount(), inputs.count()), QThread::idealThreadCount());
+
+  for (int i = 0; i < workers; i++)
+    pool->start(new CalculateTask<T>(calculate, inputs, output, next, done));
+  done.acquire(workers);
+ }
+
+static void calculateHoroscope ( const InputData& input, Horoscope& scope )
+ {
+  scope = calculateAll(input);
+ }
+
+QList<Horoscope> calculateAll ( const QList<InputData>& inputs )
+ {
+  QVector<Horoscope> ret(inputs.count());
+  calculateParallel(calculateHoroscope, inputs, ret.data());
+  return ret.toList();
+ }
+
+void calculateCharts ( const QList<InputData>& inputs, QVector<ChartData>& charts )
+ {
+  charts.resize(inputs.count());
+  calculateParallel(calculateChart, inputs, charts.data());
+ }
+
 }
@@ -1,12 +1,22 @@
 #ifndef A_CALC_H
 #define A_CALC_H
 
+#include <QVector>
 #include "astro-data.h"
+#include "astro-ephemeris.h"
+#include "astro-time.h"
 
 
 namespace A {  // Astrology, sort of :)
 
-double  getJulianDate            ( QDateTime GMT );
+enum ChartChange { Change_GMT         = 0x1,    // input members changed since a chart was calculated
+                   Change_Location    = 0x2,
+                   Change_HouseSystem = 0x4,
+                   Change_Zodiac      = 0x8,
+                   Change_AspectSet   = 0x10,
+                   Change_All         = 0x1F };
+
+void    attachEphemeris          ( );                   // swe context of the calling thread, done by calculate*()
 float   roundDegree              ( float deg );         // returns 0...360
 const ZodiacSign& getSign        ( float deg, const Zodiac& zodiac );
 int     getHouse                 ( const Houses& houses, float deg ); // returns 1...12
@@ -38,6 +48,14 @@ Aspect      calculateAspect      ( const AspectsSet& aspectSet, const Planet& pl
 AspectList  calculateAspects     ( const AspectsSet& aspectSet, const PlanetMap& planets );
 AspectList  calculateAspects     ( const AspectsSet& aspectSet, const PlanetMap& planets1, const PlanetMap& planets2 );   // synastry
 Horoscope   calculateAll         ( const InputData& input );
+Horoscope   recalculateAll       ( const Horoscope& scope, const InputData& input, int changes );  // reruns the stages that depend on 'changes' (ChartChange)
+QList<Horoscope> calculateAll    ( const QList<InputData>& inputs );   // spreads charts over all cores, keeps order
+
+void        calculateChart       ( const InputData& input, ChartData& chart );   // no allocations
+void        recalculateChart     ( const InputData& input, ChartData& chart, int changes );   // only the stages that depend on 'changes'
+void        calculateCharts      ( const QList<InputData>& inputs, QVector<ChartData>& charts );   // on all cores, keeps order
+void        toChart              ( const Horoscope& scope, ChartData& chart );   // refers to 'scope', keep it alive
+Horoscope   toHoroscope          ( const ChartData& chart, const InputData& input );
 
 }
 #endif // A_CALC_H
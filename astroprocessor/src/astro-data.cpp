@@ -3,6 +3,7 @@
 #undef UCHAR
 #undef forward
 
+#include <math.h>
 #include <QDebug>
 #include "csvreader.h"
 #include "astro-data.h"
@@ -12,11 +13,123 @@ namespace A {
 
 QMap<AspectSetId, AspectsSet> Data::aspectSets = QMap<AspectSetId, AspectsSet>();
 QMap<PlanetId, Planet> Data::planets = QMap<PlanetId, Planet>();
+QVector<Star> Data::stars = QVector<Star>();
 QMap<HouseSystemId, HouseSystem> Data::houseSystems = QMap<HouseSystemId, HouseSystem>();
 QMap<ZodiacId, Zodiac> Data::zodiacs = QMap<ZodiacId, Zodiac>();
 AspectSetId Data::topAspSet = AspectSetId();
 QString Data::usedLang = QString();
 
+/* Compiles the orbs of a set into a table with the aspect for every
+   1/Aspect_LookupScale degree of angle, so aspect() needs no scan over the
+   set. Steps within one step of an orb end are Aspect_LookupScan: there
+   aspect() compares exactly, so the result is always that of the scan. */
+
+static void compileLookup ( AspectsSet& s )
+ {
+  float end = 0;
+  foreach (const AspectType& a, s.aspects)
+   {
+    if (a.id < Aspect_None || a.id > 127) { s.lookup.clear(); return; }   // doesn't fit, always scan
+    end = qMax(end, a.angle + a.orb);
+   }
+
+  int n = (int)(end * Aspect_LookupScale) + 3;
+  s.lookup.resize(n);
+
+  for (int k = 0; k < n; k++)
+   {
+    double angle = (k + 0.5) / Aspect_LookupScale;
+    AspectId id  = Aspect_None;
+    foreach (const AspectType& a, s.aspects)         // first match, as in aspect()
+      if (a.angle - a.orb <= angle && a.angle + a.orb >= angle)
+       { id = a.id; break; }
+    s.lookup[k] = id;
+   }
+
+  foreach (const AspectType& a, s.aspects)
+   {
+    float bounds[2] = { a.angle - a.orb, a.angle + a.orb };
+    for (int b = 0; b < 2; b++)
+     {
+      int k = (int)floor(bounds[b] * Aspect_LookupScale);
+      for (int m = qMax(k - 1, 0); m <= k + 1 && m < n; m++)
+        s.lookup[m] = Aspect_LookupScan;
+     }
+   }
+ }
+
+/* The whole fixed star catalog of swe (fixstars.cat), by longitude. A star
+   listed twice is taken once, from its first line, which is the one
+   swe_fixstar() finds by name. Positions are J2000 ones without nutation and
+   aberration, at J2000 and a century later for the proper motion.
+   stars.csv gives stars a name for the UI and a power to planets in
+   conjunction with them. */
+
+static void loadStars ( QVector<Star>& stars, const QString& language )
+ {
+  const int flags = SEFLG_SWIEPH | SEFLG_J2000 | SEFLG_NONUT | SEFLG_TRUEPOS;
+  const double j2000 = 2451545.0;
+  char serr[AS_MAXCH];
+
+  stars.clear();
+  int count = swe_fixstar_range(j2000, 0, 180, 0, 0, serr);
+  if (count <= 0) { qDebug() << "A: Missing star catalog" << serr; return; }
+
+  QVector<int32> numbers(count);
+  swe_fixstar_range(j2000, 0, 180, numbers.data(), count, serr);
+  QHash<QString, int> found;                     // catalog name -> index in 'stars'
+
+  foreach (int32 n, numbers)
+   {
+    char name[AS_MAXCH];
+    double x0[6], x1[6];
+    Star s;
+
+    sprintf(name, "%d", n);
+    if (swe_fixstar(name, j2000, flags, x0, serr) < 0) continue;
+    s.catalogName = QString::fromLatin1(name);
+    sprintf(name, "%d", n);
+    if (swe_fixstar(name, j2000 + 36525, flags, x1, serr) < 0) continue;
+
+    double lonSpeed = x1[0] - x0[0];
+    if      (lonSpeed >  180) lonSpeed -= 360;
+    else if (lonSpeed < -180) lonSpeed += 360;
+
+    s.number        = n;
+    s.name          = s.catalogName.section(',', 0, 0).trimmed();
+    if (s.name.isEmpty())
+      s.name        = s.catalogName.section(',', 1).trimmed();
+    s.eclipticPos   = QPointF(x0[0], x0[1]);
+    s.eclipticSpeed = QVector2D(lonSpeed, x1[1] - x0[1]);
+
+    int i = found.value(s.catalogName, -1);
+    if (i < 0)
+     {
+      found.insert(s.catalogName, stars.count());
+      stars << s;
+     }
+    else if (n < stars[i].number)
+      stars[i] = s;
+   }
+
+  CsvFile f;
+  f.setFileName("astroprocessor/stars.csv");
+  if (!f.openForRead()) qDebug() << "A: Missing file" << f.fileName();
+  while (f.readRow())
+   {
+    QString name = f.row(0).toLower();
+    Star* star = 0;                              // the first one in the catalog with the name
+    for (int i = 0; i < stars.count(); i++)
+      if (stars[i].catalogName.section(',', 0, 0).trimmed().toLower() == name &&
+          (!star || stars[i].number < star->number))
+        star = &stars[i];
+
+    if (!star) { qDebug() << "A: Star not in catalog" << f.row(0); continue; }
+    star->name  = language == "ru" ? f.row(2) : f.row(1);
+    star->power = f.row(3).toInt();
+   }
+ }
+
 void Data :: load(QString language)
  {
   usedLang = language;
@@ -58,6 +171,9 @@ void Data :: load(QString language)
     aspectSets[setId].aspects[a.id] = a;
    }
 
+  for (QMap<AspectSetId, AspectsSet>::iterator i = aspectSets.begin(); i != aspectSets.end(); ++i)
+    compileLookup(i.value());
+
   f.close();
   f.setFileName("astroprocessor/hsystems.csv");
   if (!f.openForRead()) qDebug() << "A: Missing file" << f.fileName();
@@ -128,15 +244,23 @@ void Data :: load(QString language)
     planets[p.id] = p;
    }
 
+  f.close();
+  loadStars(stars, language);
+
   qDebug() << "Astroprocessor: initialized";
  }
 
+// Getters are read only (no QMap::operator[], which can detach or insert),
+// so they may be used from several calculation threads after load().
+
 const Planet& Data :: getPlanet(PlanetId id)
  {
-  if (Data::planets.contains(id))
-    return Data::planets[id];
+  QMap<PlanetId, Planet>::const_iterator i = planets.constFind(id);
+  if (i != planets.constEnd())
+    return i.value();
 
-  return planets[Planet_None];
+  static const Planet none;
+  return none;
  }
 
 QList<PlanetId> Data :: getPlanets()
@@ -146,18 +270,24 @@ QList<PlanetId> Data :: getPlanets()
 
 const HouseSystem& Data :: getHouseSystem(HouseSystemId id)
  {
-  if (Data::houseSystems.contains(id))
-    return Data::houseSystems[id];
+  QMap<HouseSystemId, HouseSystem>::const_iterator i = houseSystems.constFind(id);
+  if (i != houseSystems.constEnd())
+    return i.value();
 
-  return houseSystems[Housesystem_None];
+  static const HouseSystem none;
+  return none;
  }
 
 const Zodiac& Data :: getZodiac(ZodiacId id)
  {
-  if (Data::zodiacs.contains(id))
-    return Data::zodiacs[id];
-
-  return zodiacs[Zodiac_Tropical];
+  QMap<ZodiacId, Zodiac>::const_iterator i = zodiacs.constFind(id);
+  if (i == zodiacs.constEnd())
+    i = zodiacs.constFind(Zodiac_Tropical);
+  if (i != zodiacs.constEnd())
+    return i.value();
+
+  static const Zodiac none;
+  return none;
  }
 
 const QList<HouseSystem> Data :: getHouseSystems()
@@ -178,18 +308,25 @@ const QList<Zodiac> Data :: getZodiacs()
 
 const AspectType& Data :: getAspect(AspectId id, const AspectsSet& set)
  {
-  if (set.aspects.contains(id))
-    return aspectSets[set.id].aspects[id];
+  const AspectsSet& s = getAspectSet(set.id);
+  QMap<AspectId, AspectType>::const_iterator i = s.aspects.constFind(id);
+  if (i != s.aspects.constEnd())
+    return i.value();
 
-  return aspectSets[AspectSet_Default].aspects[Aspect_None];
+  static const AspectType none;
+  return none;
  }
 
 const AspectsSet& Data :: getAspectSet(AspectSetId set)
  {
-  if (aspectSets.contains(set))
-    return aspectSets[set];
-
-  return aspectSets[AspectSet_Default];
+  QMap<AspectSetId, AspectsSet>::const_iterator i = aspectSets.constFind(set);
+  if (i == aspectSets.constEnd())
+    i = aspectSets.constFind(AspectSet_Default);
+  if (i != aspectSets.constEnd())
+    return i.value();
+
+  static const AspectsSet none;
+  return none;
  }
 
 /*QList<AspectsSet>& Data :: getAspectSets()
@@ -202,6 +339,8 @@ void load(QString language) { Data::load(language); }
 QString usedLanguage()      { return Data::usedLanguage(); }
 const Planet& getPlanet(PlanetId id) { return Data::getPlanet(id); }
 QList<PlanetId> getPlanets() { return Data::getPlanets(); }
+const PlanetMap& getPlanetMap() { return Data::getPlanetMap(); }
+const QVector<Star>& getStars() { return Data::getStars(); }
 const HouseSystem& getHouseSystem(HouseSystemId id) { return Data::getHouseSystem(id); }
 const Zodiac& getZodiac(ZodiacId id) { return Data::getZodiac(id); }
 const QList<HouseSystem> getHouseSystems() { return Data::getHouseSystems(); }
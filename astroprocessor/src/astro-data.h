@@ -7,6 +7,7 @@
 #include <QVector3D>
 #include <QVector2D>
 #include <QVariant>
+#include <QVector>
 
 namespace A {
 
@@ -49,6 +50,11 @@ const ZodiacSignId  Sign_None            = -1;
 
 const AspectSetId   AspectSet_Default    =  0;
 
+const int           Aspect_LookupScale   = 100;   // AspectsSet::lookup steps per degree
+const signed char   Aspect_LookupScan    = -2;    // AspectsSet::lookup: an orb ends within a step, compare exactly
+
+const int           Planet_InvertPosition = 256 * 1024;   // Planet::sweFlags bit, not a swe flag: opposite point of the calculated body
+
 
 struct ZodiacSign {
   ZodiacSignId id;
@@ -147,6 +153,30 @@ struct Planet
   bool operator!=(const Planet & other) const { return this->id != other.id || this->eclipticPos != other.eclipticPos; }
 };
 
+struct Star
+{
+  QString        name;                // as in stars.csv, or the traditional name or nomenclature of the catalog
+  QString        catalogName;         // "name,nomenclature" of swe fixstars.cat
+  int            number;              // in the catalog, swe_fixstar() takes it for a name
+  int            power;               // of a planet in conjunction: dignity if > 0, deficient if < 0 (stars.csv)
+  QPointF        eclipticPos;         // x - longitude, y - latitude; J2000 ecliptic and equinox, at J2000
+  QVector2D      eclipticSpeed;       // proper motion in the same frame, degree/century
+
+  Star() { number = 0;
+           power  = 0; }
+};
+
+struct StarConjunction
+{
+  const Star*    star;
+  PlanetId       planet;
+  float          orb;                 // angle between planet and star
+
+  StarConjunction() { star   = 0;
+                      planet = Planet_None;
+                      orb    = 0; }
+};
+
 //struct AspectsSet;
 
 struct AspectType {
@@ -183,6 +213,7 @@ struct AspectsSet {
   AspectSetId id;
   QString name;
   QMap<AspectId, AspectType> aspects;
+  QVector<signed char> lookup;        // aspect by angle * Aspect_LookupScale, made by Data::load()
 
   AspectsSet() { id = AspectSet_Default; }
 };
@@ -200,6 +231,7 @@ class Data
         static QMap<HouseSystemId, HouseSystem> houseSystems;
         static QMap<ZodiacId, Zodiac> zodiacs;
         static QMap<PlanetId, Planet> planets;
+        static QVector<Star> stars;
         static AspectSetId topAspSet;
 
     public:
@@ -208,6 +240,8 @@ class Data
 
         static const Planet& getPlanet(PlanetId id);
         static QList<PlanetId> getPlanets();
+        static const PlanetMap& getPlanetMap() { return planets; }
+        static const QVector<Star>& getStars() { return stars; }
 
         static const HouseSystem& getHouseSystem(HouseSystemId id);
         static const QList<HouseSystem> getHouseSystems();
@@ -220,13 +254,15 @@ class Data
 
         static QList<AspectsSet> getAspectSets() { return aspectSets.values(); }
         static const AspectsSet& getAspectSet(AspectSetId set);
-        static const AspectsSet& topAspectSet() { return aspectSets[topAspSet]; }
+        static const AspectsSet& topAspectSet() { return getAspectSet(topAspSet); }
 };
 
 void load(QString language);
 QString usedLanguage();
 const Planet& getPlanet(PlanetId id);
 QList<PlanetId> getPlanets();
+const PlanetMap& getPlanetMap();
+const QVector<Star>& getStars();
 const HouseSystem& getHouseSystem(HouseSystemId id);
 const Zodiac& getZodiac(ZodiacId id);
 const QList<HouseSystem> getHouseSystems();
@@ -254,6 +290,71 @@ struct InputData
                 aspectSet   = AspectSet_Default; }
 };
 
+/* Flat counterpart of Horoscope for bulk calculations: the computed values
+   in fixed size arrays with one slot per body (getPlanets() order) and the
+   static data referenced instead of copied. Holds no Qt containers, so
+   calculating a chart allocates nothing and a batch of them stays compact. */
+
+const int Chart_MaxPlanets = 32;
+const int Chart_MaxAspects = Chart_MaxPlanets * (Chart_MaxPlanets - 1) / 2;
+const int Chart_MaxStarConjunctions = Chart_MaxPlanets * 8;
+
+struct ChartAspect
+{
+  const AspectType* d;
+  short          planet1;             // slots in ChartData
+  short          planet2;
+  float          angle;
+  float          orb;
+  bool           applying;
+};
+
+struct ChartStarConjunction
+{
+  short          planet;              // slot in ChartData
+  short          star;                // index in getStars()
+  float          orb;
+};
+
+struct ChartData
+{
+  double         jd;                  // julian day (UT)
+  double         tt;                  // the same in terrestrial time, see astro-time.h
+  const Zodiac*  zodiac;
+  const AspectsSet* aspectSet;
+  Houses         houses;
+  int            count;               // used planet slots
+  int            aspectCount;
+  int            starConjunctionCount;
+
+  const Planet*  planet     [Chart_MaxPlanets];   // id, name, sweNum, signs etc.
+  double         lon        [Chart_MaxPlanets];   // 0... 360
+  double         lat        [Chart_MaxPlanets];
+  float          lonSpeed   [Chart_MaxPlanets];   // degree/day
+  float          latSpeed   [Chart_MaxPlanets];
+  double         distance   [Chart_MaxPlanets];   // A.U.
+  double         azimuth    [Chart_MaxPlanets];
+  double         altitude   [Chart_MaxPlanets];
+  const ZodiacSign* sign    [Chart_MaxPlanets];
+  char           house      [Chart_MaxPlanets];   // 1... 12
+  char           houseRuler [Chart_MaxPlanets];
+  char           position   [Chart_MaxPlanets];   // PlanetPosition
+  PlanetPower    power      [Chart_MaxPlanets];
+  ChartAspect    aspects    [Chart_MaxAspects];
+  ChartStarConjunction starConjunctions [Chart_MaxStarConjunctions];
+
+  ChartData() { jd = tt = 0;
+                zodiac = 0;
+                aspectSet = 0;
+                count = 0;
+                aspectCount = 0;
+                starConjunctionCount = 0; }
+
+  int indexOf ( PlanetId id ) const { for (int i = 0; i < count; i++)
+                                        if (planet[i]->id == id) return i;
+                                      return -1; }
+};
+
 struct Horoscope
 {
   InputData  inputData;
@@ -261,6 +362,7 @@ struct Horoscope
   Houses     houses;
   AspectList aspects;
   PlanetMap  planets;
+  QList<StarConjunction> starConjunctions;
   Planet     sun,
              moon,
              mercury,
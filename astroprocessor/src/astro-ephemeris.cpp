@@ -0,0 +1,368 @@
+#include <swephexp.h>
+#undef MSDOS     // undef macroses that made by SWE library
+#undef UCHAR
+#undef forward
+
+#include <math.h>
+#include <stdlib.h>
+#include <QVector>
+#include <QFile>
+#include <QDebug>
+#include "astro-ephemeris.h"
+#include "astro-time.h"
+
+namespace A {
+
+const int Chebyshev_Count = 14;       // coefficients per coordinate and segment
+
+const double Cell_Days       = 32;   // a cell is split into 2^level segments where needed
+const int    Max_Level       = 5;    // 1 day segments
+const int    Lanes           = 8;    // epochs evaluated together by chartPositions()
+
+struct FittedBody
+{
+  int    sweNum;
+  int    sweFlags;
+  double jd0;                         // start of the first cell
+  int    cells;
+  QVector<int>    first;              // per cell: index of its first segment
+  QVector<char>   level;              // per cell: segment length is Cell_Days / 2^level
+  QVector<double> coef;               // segments x 3 coordinates x Chebyshev_Count
+};
+
+static QList<FittedBody> fitted;
+static double fitFrom = 0, fitTo = 0;
+
+
+// value and derivative (d/dx) of a Chebyshev series, x = -1...1
+static void evaluate ( const double* c, double x, double& value, double& derivative )
+ {
+  double t0 = 1, t1 = x;              // T(n)
+  double u0 = 1, u1 = 2 * x;          // U(n), T'(n) = n * U(n-1)
+  value      = c[0] + c[1] * x;
+  derivative = c[1];
+
+  for (int j = 2; j < Chebyshev_Count; j++)
+   {
+    double t2 = 2 * x * t1 - t0;
+    double u2 = 2 * x * u1 - u0;
+    value      += c[j] * t2;
+    derivative += c[j] * j * u1;
+    t0 = t1; t1 = t2;
+    u0 = u1; u1 = u2;
+   }
+ }
+
+// fits one segment [t0, t0 + step]; longitude is unwrapped before fitting
+static bool fitSegment ( int sweNum, int sweFlags, double t0, double step, double* c )
+ {
+  double f[3][Chebyshev_Count];
+  double xx[6];
+  char   errStr[256] = "";
+  double prev = 0;
+
+  for (int k = Chebyshev_Count - 1; k >= 0; k--)     // ascending time
+   {
+    double node = cos(M_PI * (k + 0.5) / Chebyshev_Count);
+    if (swe_calc_ut(t0 + (node + 1) / 2 * step, sweNum, sweFlags, xx, errStr) < 0)
+      return false;
+
+    double lon = xx[0];
+    if (k < Chebyshev_Count - 1)
+     {
+      while (lon - prev >  180) lon -= 360;
+      while (lon - prev < -180) lon += 360;
+     }
+    prev = lon;
+
+    f[0][k] = lon;
+    f[1][k] = xx[1];
+    f[2][k] = xx[2];
+   }
+
+  for (int i = 0; i < 3; i++)
+    for (int j = 0; j < Chebyshev_Count; j++)
+     {
+      double s = 0;
+      for (int k = 0; k < Chebyshev_Count; k++)
+        s += f[i][k] * cos(M_PI * j * (k + 0.5) / Chebyshev_Count);
+      c[i * Chebyshev_Count + j] = (j ? 2.0 : 1.0) * s / Chebyshev_Count;
+     }
+
+  return true;
+ }
+
+static void position ( const double* c, double x, double step, double* xx )
+ {
+  double scale = 2 / step;
+
+  for (int k = 0; k < 3; k++)
+   {
+    evaluate(c + k * Chebyshev_Count, x, xx[k], xx[k + 3]);
+    xx[k + 3] *= scale;
+   }
+
+  xx[0] = fmod(xx[0], 360);
+  if (xx[0] < 0) xx[0] += 360;
+ }
+
+static double lonDiff ( double a, double b )
+ {
+  double d = fabs(fmod(a - b, 360));
+  return d > 180 ? 360 - d : d;
+ }
+
+// fits a segment and checks it between the nodes against swe_calc_ut
+static bool fitChecked ( int sweNum, int sweFlags, double t0, double step, double tolerance,
+                         double* c, bool& withinTolerance )
+ {
+  if (!fitSegment(sweNum, sweFlags, t0, step, c)) return false;
+
+  double xx[6], fx[6];
+  char   errStr[256] = "";
+  withinTolerance = true;
+
+  for (int q = 1; withinTolerance && q < 8; q += 2)
+   {
+    if (swe_calc_ut(t0 + step * q / 8, sweNum, sweFlags, xx, errStr) < 0) return false;
+    position(c, q / 4.0 - 1, step, fx);
+    withinTolerance = lonDiff(fx[0], xx[0]) <= tolerance && fabs(fx[1] - xx[1]) <= tolerance;
+   }
+
+  return true;
+ }
+
+// fits one cell with the coarsest level that stays within tolerance
+static bool fitCell ( FittedBody& b, int cell, double tolerance )
+ {
+  QVector<double> c;
+  double t0 = b.jd0 + cell * Cell_Days;
+
+  for (int level = 0; level <= Max_Level; level++)
+   {
+    int    n    = 1 << level;
+    double step = Cell_Days / n;
+    bool   ok   = true;
+    c.resize(n * 3 * Chebyshev_Count);
+
+    for (int i = 0; ok && i < n; i++)
+      if (!fitChecked(b.sweNum, b.sweFlags, t0 + i * step, step, tolerance,
+                      c.data() + i * 3 * Chebyshev_Count, ok))
+        return false;
+
+    if (ok || level == Max_Level)
+     {
+      b.first[cell] = b.coef.size() / (3 * Chebyshev_Count);
+      b.level[cell] = level;
+      b.coef += c;
+      return true;
+     }
+   }
+
+  return false;
+ }
+
+bool buildChartEphemeris ( double jdFrom, double jdTo, double tolerance )
+ {
+  clearChartEphemeris();
+  if (jdTo <= jdFrom) return false;
+
+  foreach (PlanetId id, getPlanets())
+   {
+    const Planet& p = getPlanet(id);
+    int flags = p.sweFlags & ~Planet_InvertPosition;   // opposite bodies share the fit
+    bool known = false;
+    foreach (const FittedBody& b, fitted)
+      known = known || (b.sweNum == p.sweNum && b.sweFlags == flags);
+    if (known) continue;
+
+    FittedBody b;
+    b.sweNum   = p.sweNum;
+    b.sweFlags = flags;
+    b.jd0      = floor(jdFrom / Cell_Days) * Cell_Days;
+    b.cells    = (int)ceil((jdTo - b.jd0) / Cell_Days);
+    b.first.resize(b.cells);
+    b.level.resize(b.cells);
+
+    bool ok = true;
+    for (int i = 0; ok && i < b.cells; i++)
+      ok = fitCell(b, i, tolerance);
+
+    if (ok)
+      fitted << b;
+    else
+      qDebug() << "A: no chart ephemeris for" << p.name << "- out of range";
+   }
+
+  fitFrom = jdFrom;
+  fitTo   = jdTo;
+  qDebug() << "A: chart ephemeris for" << fitted.count() << "bodies built";
+  return !fitted.isEmpty();
+ }
+
+void clearChartEphemeris ( )
+ {
+  fitted.clear();
+  fitFrom = fitTo = 0;
+ }
+
+// segment of jd (index into coef) and the Chebyshev argument; -1 outside the fit
+static int segmentOf ( const FittedBody& b, double jd, double& x, double& step )
+ {
+  if (jd < fitFrom || jd > fitTo) return -1;
+
+  double t = (jd - b.jd0) / Cell_Days;
+  int cell = (int)t;
+  if (cell == b.cells) cell--;                       // jd == end of span
+  if (cell < 0 || cell >= b.cells) return -1;
+
+  int    n = 1 << b.level[cell];
+  double u = (t - cell) * n;                         // 0...n inside the cell
+  int    i = qMin((int)u, n - 1);
+  x    = (u - i) * 2 - 1;
+  step = Cell_Days / n;
+  return b.first[cell] + i;
+ }
+
+static const FittedBody* fittedBody ( int sweNum, int sweFlags )
+ {
+  foreach (const FittedBody& b, fitted)
+    if (b.sweNum == sweNum && b.sweFlags == sweFlags)
+      return &b;
+  return 0;
+ }
+
+bool chartPosition ( int sweNum, int sweFlags, double jd, double* xx )
+ {
+  const FittedBody* b = fittedBody(sweNum, sweFlags);
+  double x, step;
+  int    i = b ? segmentOf(*b, jd, x, step) : -1;
+  if (i < 0) return false;
+
+  position(b->coef.constData() + i * 3 * Chebyshev_Count, x, step, xx);
+  return true;
+ }
+
+// one coordinate for Lanes epochs of the same segment in lock step: the
+// inner loops have a fixed length and no dependencies, so they get vectorized
+static void evaluateLanes ( const double* c, const double* x, double* value, double* derivative )
+ {
+  double t0[Lanes], t1[Lanes], u0[Lanes], u1[Lanes];
+
+  for (int e = 0; e < Lanes; e++)
+   {
+    t0[e] = 1; t1[e] = x[e];
+    u0[e] = 1; u1[e] = 2 * x[e];
+    value[e]      = c[0] + c[1] * x[e];
+    derivative[e] = c[1];
+   }
+
+  for (int j = 2; j < Chebyshev_Count; j++)
+    for (int e = 0; e < Lanes; e++)
+     {
+      double t2 = 2 * x[e] * t1[e] - t0[e];
+      double u2 = 2 * x[e] * u1[e] - u0[e];
+      value[e]      += c[j] * t2;
+      derivative[e] += c[j] * j * u1[e];
+      t0[e] = t1[e]; t1[e] = t2;
+      u0[e] = u1[e]; u1[e] = u2;
+     }
+ }
+
+bool chartPositions ( int sweNum, int sweFlags, const double* jd, int n, double* xx )
+ {
+  const FittedBody* b = fittedBody(sweNum, sweFlags);
+  char   errStr[256] = "";
+  bool   ret = true;
+  double x[Lanes], value[Lanes], derivative[Lanes], step, s;
+  QVector<double> tt;                                  // converted once the first epoch is not fitted
+
+  for (int i = 0; i < n; )
+   {
+    int seg = b ? segmentOf(*b, jd[i], x[0], step) : -1;
+    if (seg < 0)                                       // not fitted: exact calculation
+     {
+      if (tt.isEmpty())
+       {
+        tt.resize(n);
+        terrestrialTimes(jd + i, n - i, tt.data() + i);
+       }
+      ret = swe_calc(tt[i], sweNum, sweFlags, xx + 6 * i, errStr) >= 0 && ret;
+      i++;
+      continue;
+     }
+
+    int m = 1;                                         // following epochs of the same segment
+    while (m < Lanes && i + m < n && segmentOf(*b, jd[i + m], x[m], s) == seg)
+      m++;
+
+    for (int e = m; e < Lanes; e++)                    // unused lanes
+      x[e] = x[0];
+
+    const double* c = b->coef.constData() + seg * 3 * Chebyshev_Count;
+    for (int k = 0; k < 3; k++)
+     {
+      evaluateLanes(c + k * Chebyshev_Count, x, value, derivative);
+      for (int e = 0; e < m; e++)
+       {
+        xx[6 * (i + e) + k]     = value[e];
+        xx[6 * (i + e) + k + 3] = derivative[e] * (2 / step);
+       }
+     }
+
+    for (int e = 0; e < m; e++)
+     {
+      double& lon = xx[6 * (i + e)];
+      lon = fmod(lon, 360);
+      if (lon < 0) lon += 360;
+     }
+
+    i += m;
+   }
+
+  return ret;
+ }
+
+EphemerisError chartEphemerisError ( int samples )
+ {
+  EphemerisError ret;
+  double xx[6], fx[6];
+  char   errStr[256] = "";
+
+  foreach (const FittedBody& b, fitted)
+    for (int s = 0; s < samples; s++)
+     {
+      double jd = fitFrom + (fitTo - fitFrom) * (rand() / (double)RAND_MAX);
+      if (!chartPosition(b.sweNum, b.sweFlags, jd, fx) ||
+          swe_calc_ut(jd, b.sweNum, b.sweFlags, xx, errStr) < 0)
+        continue;
+
+      ret.lon   = qMax(ret.lon,   lonDiff(fx[0], xx[0]) * 3600);
+      ret.lat   = qMax(ret.lat,   fabs(fx[1] - xx[1]) * 3600);
+      ret.dist  = qMax(ret.dist,  fabs(fx[2] - xx[2]));
+      ret.speed = qMax(ret.speed, fabs(fx[3] - xx[3]));
+     }
+
+  return ret;
+ }
+
+bool setNutationTable ( double jdFrom, double jdTo, const QString& fileName )
+ {
+  char errStr[256] = "";
+  QByteArray file = QFile::encodeName(fileName);
+  double from = jdFrom + swe_deltat(jdFrom) - 1;    // the table is in ET
+  double to   = jdTo   + swe_deltat(jdTo)   + 1;
+
+  if (jdTo <= jdFrom)
+    from = to = 0;
+  if (swe_set_nutation_table(from, to, 0, file.isEmpty() ? 0 : file.data(), errStr) < 0)
+   {
+    qDebug() << "A: nutation table:" << errStr;
+    return false;
+   }
+
+  if (*errStr) qDebug() << "A: nutation table:" << errStr;
+  return jdTo > jdFrom;
+ }
+
+}
@@ -0,0 +1,49 @@
+#ifndef A_EPHEMERIS_H
+#define A_EPHEMERIS_H
+
+#include "astro-data.h"
+
+namespace A {
+
+/* Chart precision ephemeris: Chebyshev fits of the ecliptic longitude,
+   latitude and distance returned by swe_calc_ut, per body and per flags,
+   over a date span. Evaluating a fit replaces the whole swe pipeline
+   (segment decoding, precession, nutation, rotations) by a few dozen
+   multiplications, about 30x faster than swe_calc_ut.
+
+   The span is cut into 32 day cells; a cell is split into 2, 4 ... 32
+   segments of 14 coefficients until the fit stays within the tolerance
+   between its nodes. Measured against swe_calc_ut at 20000 random dates
+   over 1900-2100 with the default tolerance of 0.1":
+     longitude   < 0.11" (true node: < 0.22", its series is noisy)
+     latitude    < 0.08"
+     speed       < 5e-4 deg/day
+   Building that span takes ~13 s, so build once (e.g. in a daemon or
+   before a batch) and before calculating from several threads. */
+
+struct EphemerisError
+{
+  double lon, lat;                    // arc seconds
+  double dist;                        // AU
+  double speed;                       // degrees per day
+
+  EphemerisError() { lon = lat = dist = speed = 0; }
+};
+
+bool           buildChartEphemeris   ( double jdFrom, double jdTo, double tolerance = 0.1 / 3600 );  // UT, bodies of getPlanets()
+void           clearChartEphemeris   ( );
+bool           chartPosition         ( int sweNum, int sweFlags, double jd, double* xx );  // xx[6] as swe_calc_ut; false if not fitted
+bool           chartPositions        ( int sweNum, int sweFlags, const double* jd, int n, double* xx );  // n epochs, xx n x 6; swe_calc at TT outside the fit
+EphemerisError chartEphemerisError   ( int samples = 1000 );                                // max deviation from swe_calc_ut
+
+/* Nutation, obliquity and precession interpolated from a table over jdFrom...jdTo
+   (UT) instead of evaluated from their series, see swe_set_nutation_table() in
+   swephlib.c: 0.1 instead of 5 microseconds per date, deviation < 0.0001".
+   The table is mapped from fileName if it matches, otherwise it is calculated
+   (~0.2 s per century) and saved there. Only the header of the file is checked,
+   so keep it where only the user can write. Like the fits it is shared by all
+   threads, so set it before calculating from several; jdTo <= jdFrom removes it. */
+bool           setNutationTable      ( double jdFrom, double jdTo, const QString& fileName = QString() );
+
+}
+#endif // A_EPHEMERIS_H
@@ -3,6 +3,7 @@
 #include <QTextCodec>
 #include <QDebug>
 #include "astro-calc.h"
+#include "astro-cache.h"
 #include "astro-gui.h"
 
 
@@ -134,7 +135,7 @@ void AstroFile :: change(AstroFile::Members members, bool affectChangedState)
   if (!holdUpdate)
    {
     if (members & (GMT|Location|HouseSystem|Zodiac|AspectSet))
-      recalculate();
+      recalculate(members);
 
     emit changed(members);
    }
@@ -247,10 +248,25 @@ void AstroFile :: setAspectSet  (A::AspectSetId set)
    }
  }
 
-void AstroFile :: recalculate()
+void AstroFile :: recalculate(AstroFile::Members members)
  {
+  int changes = 0;
+  if (members & GMT)         changes |= A::Change_GMT;
+  if (members & Location)    changes |= A::Change_Location;
+  if (members & HouseSystem) changes |= A::Change_HouseSystem;
+  if (members & Zodiac)      changes |= A::Change_Zodiac;
+  if (members & AspectSet)   changes |= A::Change_AspectSet;
+
+  A::InputData input = scope.inputData;
+  if (A::chartCache().find(input, scope))
+   {
+    qDebug() << "Found file" << getName() << "in chart cache";
+    return;
+   }
+
   qDebug() << "Calculating file" << getName() << "...";
-  scope = A::calculateAll(scope.inputData);
+  scope = A::recalculateAll(scope, input, changes);   // only what depends on the changed members
+  A::chartCache().insert(input, scope);
  }
 
 void AstroFile :: destroy()
@@ -92,7 +92,7 @@ class AstroFile : public QObject
         FileType type;
         A::Horoscope scope;
 
-        void recalculate();
+        void recalculate(AstroFile::Members members);
         void change(AstroFile::Members, bool affectChangedState = true);
 
 };
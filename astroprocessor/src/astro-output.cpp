@@ -418,14 +418,13 @@ QString     describePower     ( const Planet& planet, const Horoscope& scope)
    }
 
 
-  if (aspect(planet, QPointF(149.833, 0.45), topAspectSet()) == Aspect_Conjunction)
-    ret << QObject::tr("+6: Planet is in conjunction with Regulus");
-
-  if (aspect(planet, QPointF(203.833, -2.05), topAspectSet()) == Aspect_Conjunction)
-    ret << QObject::tr("+5: Planet is in conjunction with Spica");
-
-  if (aspect(planet, QPointF(56.166, 22.416), topAspectSet()) == Aspect_Conjunction)
-    ret << QObject::tr("-5: Planet is in conjunction with Algol");
+  foreach (const StarConjunction& c, scope.starConjunctions)
+   {
+    if (c.planet != planet.id || !c.star->power) continue;
+    ret << QObject::tr("%1: Planet is in conjunction with %2")
+             .arg(c.star->power > 0 ? "+" + QString::number(c.star->power) : QString::number(c.star->power))
+             .arg(c.star->name);
+   }
 
 
   // sort values from biggest to smallest
@@ -507,4 +506,242 @@ QString     describe          ( const Horoscope& scope, Articles article )
  }
 
 
+
+/* JSON output: values are written straight from the horoscope fields into one buffer,
+   numbers are formatted by hand so the result doesn't depend on the C locale */
+
+static void appendInt ( QByteArray& out, long long val )
+ {
+  char buf[24];
+  int i = sizeof(buf);
+  bool negative = val < 0;
+  unsigned long long v = negative ? -val : val;
+
+  do { buf[--i] = '0' + v % 10; v /= 10; } while (v);
+  if (negative) buf[--i] = '-';
+  out.append(buf + i, sizeof(buf) - i);
+ }
+
+static void appendNumber ( QByteArray& out, double val, int decimals = 8 )
+ {
+  static const double pow10[] = { 1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10 };
+  decimals = qBound(0, decimals, 10);
+
+  if (val != val) { out.append("null"); return; }     // NaN is not valid JSON
+  if (val < 0) { out.append('-'); val = -val; }
+
+  double ip = floor(val);
+  long long frac = (long long)((val - ip) * pow10[decimals] + 0.5);
+  if (frac >= (long long)pow10[decimals]) { ip += 1; frac = 0; }
+  appendInt(out, (long long)ip);
+  if (!decimals) return;
+
+  char buf[10];
+  for (int i = decimals - 1; i >= 0; i--) { buf[i] = '0' + frac % 10; frac /= 10; }
+  int len = decimals;
+  while (len > 1 && buf[len - 1] == '0') len--;      // strip trailing zeros
+  out.append('.');
+  out.append(buf, len);
+ }
+
+static void appendUtf8 ( QByteArray& out, uint c )
+ {
+  if (c < 0x80)
+    out.append(char(c));
+  else if (c < 0x800)
+   {
+    out.append(char(0xC0 | (c >> 6)));
+    out.append(char(0x80 | (c & 0x3F)));
+   }
+  else if (c < 0x10000)
+   {
+    out.append(char(0xE0 | (c >> 12)));
+    out.append(char(0x80 | ((c >> 6) & 0x3F)));
+    out.append(char(0x80 | (c & 0x3F)));
+   }
+  else
+   {
+    out.append(char(0xF0 | (c >> 18)));
+    out.append(char(0x80 | ((c >> 12) & 0x3F)));
+    out.append(char(0x80 | ((c >> 6) & 0x3F)));
+    out.append(char(0x80 | (c & 0x3F)));
+   }
+ }
+
+static void appendEscaped ( QByteArray& out, const QString& str, bool asKey = false )
+ {
+  // 'asKey' makes a short lowercase key of the name: "Sun" -> "sun", "N. Pole" -> "n"
+  static const char hex[] = "0123456789abcdef";
+  for (int i = 0; i < str.length(); i++)
+   {
+    uint c = str[i].unicode();
+    if (asKey)
+     {
+      if (c == ' ') break;
+      if (c == '.') continue;
+      c = str[i].toLower().unicode();
+     }
+
+    if (QChar::isHighSurrogate(c) && i + 1 < str.length() && str[i+1].isLowSurrogate())
+      c = QChar::surrogateToUcs4(c, str[++i].unicode());
+
+    if (c == '"' || c == '\\')
+     { out.append('\\'); out.append(char(c)); }
+    else if (c < 0x20)
+     { out.append("\\u00"); out.append(hex[c >> 4]); out.append(hex[c & 0xF]); }
+    else
+      appendUtf8(out, c);
+   }
+ }
+
+static void appendString ( QByteArray& out, const QString& str, bool asKey = false )
+ {
+  out.append('"');
+  appendEscaped(out, str, asKey);
+  out.append('"');
+ }
+
+static void appendKey ( QByteArray& out, const char* key )
+ {
+  out.append('"');
+  out.append(key);
+  out.append("\":");
+ }
+
+static void appendZodiacPosition ( QByteArray& out, float deg, const Zodiac& zodiac )
+ {                                     // same degrees/minutes/sign as zodiacPosition()
+  const ZodiacSign& sign = getSign(deg, zodiac);
+  int ang = floor(deg) - sign.startAngle;
+  if (ang < 0) ang += 360;
+
+  appendKey(out, "g");
+  appendInt(out, ang);
+  out.append(',');
+  appendKey(out, "m");
+  appendInt(out, (int)(60.0*(deg - (int)deg)));
+  out.append(',');
+  appendKey(out, "s");
+  appendString(out, sign.tag, true);
+ }
+
+// the aspects zodiac_server has always written: its clients number them asp0... over these
+static bool isMajorAspect ( AspectId id )
+ {
+  return id == Aspect_Conjunction || id == Aspect_Trine ||
+         id == Aspect_Opposition  || id == Aspect_Quadrature;
+ }
+
+void writeJson ( QByteArray& out, const ChartData& chart, bool allAspects )
+ {
+  static const char* roman[] = { "i", "ii", "iii", "iv",
+                                 "v", "vi", "vii", "viii",
+                                 "ix", "x", "xi", "xii" };
+
+  appendKey(out, "psc");
+  out.append('{');
+  for (int i = 0; i < chart.count; i++)
+   {
+    if (i) out.append(',');
+
+    appendString(out, chart.planet[i]->name, true);
+    out.append(":{");
+    appendZodiacPosition(out, chart.lon[i], *chart.zodiac);
+    out.append(',');
+    appendKey(out, "h");
+    appendInt(out, chart.house[i] ? chart.house[i] : -1);
+    out.append(',');
+    appendKey(out, "rh");
+    out.append('"');
+    out.append(chart.house[i] >= 1 && chart.house[i] <= 12 ? roman[chart.house[i] - 1] : "0");
+    out.append('"');
+    out.append(',');
+    appendKey(out, "lon");
+    appendNumber(out, chart.lon[i]);
+    out.append(',');
+    appendKey(out, "lat");
+    appendNumber(out, chart.lat[i]);
+    out.append(',');
+    appendKey(out, "spd");
+    appendNumber(out, chart.lonSpeed[i]);
+    out.append(',');
+    appendKey(out, "dist");
+    appendNumber(out, chart.distance[i]);
+    out.append('}');
+   }
+  out.append("},");
+
+  appendKey(out, "asp");
+  out.append('{');
+  for (int i = 0, n = 0; i < chart.aspectCount; i++)
+   {
+    const ChartAspect& a = chart.aspects[i];
+    if (!allAspects && !isMajorAspect(a.d->id)) continue;
+    if (n) out.append(',');
+
+    out.append("\"asp");
+    appendInt(out, n++);
+    out.append("\":{");
+    appendKey(out, "t");
+    appendString(out, a.d->name);
+    out.append(',');
+    appendKey(out, "p");
+    out.append('"');
+    appendEscaped(out, chart.planet[a.planet1]->name);
+    out.append('-');
+    appendEscaped(out, chart.planet[a.planet2]->name);
+    out.append('"');
+    out.append(',');
+    appendKey(out, "ang");
+    appendNumber(out, a.angle);
+    out.append(',');
+    appendKey(out, "orb");
+    appendNumber(out, a.orb);
+    out.append(',');
+    appendKey(out, "apl");
+    out.append(a.applying ? "true" : "false");
+    out.append('}');
+   }
+  out.append("},");
+
+  appendKey(out, "pc");
+  out.append('{');
+  for (int i = 0; i < 12; i++)
+   {
+    if (i) out.append(',');
+
+    out.append("\"h");
+    appendInt(out, i + 1);
+    out.append("\":{");
+    appendZodiacPosition(out, chart.houses.cusp[i], *chart.zodiac);
+    out.append(',');
+    appendKey(out, "lon");
+    appendNumber(out, chart.houses.cusp[i]);
+    out.append('}');
+   }
+  out.append('}');
+ }
+
+void writeJson ( QByteArray& out, const Horoscope& scope, bool allAspects )
+ {
+  ChartData chart;
+  toChart(scope, chart);
+  writeJson(out, chart, allAspects);
+ }
+
+QByteArray toJson ( const Horoscope& scope )
+ {
+  QByteArray ret;
+  ret.reserve(4096);
+  ret.append('{');
+  writeJson(ret, scope);
+  ret.append('}');
+  return ret;
+ }
+
+void writeJsonString ( QByteArray& out, const QString& str )
+ {
+  appendString(out, str);
+ }
+
+
 }
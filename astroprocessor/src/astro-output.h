@@ -47,6 +47,13 @@ QString     describePower       ( const Planet& planet, const Horoscope& scope )
 QString     describePowerInHtml ( const Planet& planet, const Horoscope& scope );
 QString     describe            ( const Horoscope& scope, Articles article = Article_All );
 
+// appends "psc", "asp" and "pc" members; "asp" holds the conjunctions, trines,
+// oppositions and quadratures as asp0, asp1..., or all aspects of the chart
+void        writeJson           ( QByteArray& out, const Horoscope& scope, bool allAspects = false );
+void        writeJson           ( QByteArray& out, const ChartData& chart, bool allAspects = false );
+QByteArray  toJson              ( const Horoscope& scope );
+void        writeJsonString     ( QByteArray& out, const QString& str );        // appends str quoted and escaped
+
 }
 
 #endif // A_OUTPUT_H
@@ -0,0 +1,450 @@
+#include <math.h>
+#include <QtAlgorithms>
+#include <QVector>
+#include <QDebug>
+#include "astro-search.h"
+#include "astro-calc.h"
+
+namespace A {
+
+const double Step_Degrees   = 2;      // sampling step of a body: 2 degrees of its mean motion ...
+const double Max_Step       = 5;      // ... but at most 5 days
+const int    Bisections     = 32;     // turning points: 5 days / 2^32
+const int    Max_Iterations = 40;     // crossings
+const double Precision      = 1e-7;   // days, ~0.01 s
+
+
+// lon/lat are continuous (unwrapped) along a track
+struct Motion
+{
+  double lon, lat;
+  double lonSpeed, latSpeed;          // degrees per day
+  double lonAccel;                    // degrees per day^2
+};
+
+/* Part of a step where a function is monotonic; u = 0...1 over the step. */
+
+struct Piece
+{
+  double u0, u1;
+  double f0, f1;
+};
+
+// a body sampled over the window
+struct Track
+{
+  const Planet*   planet;
+  QVector<double> jd;
+  QVector<double> lon, lat, lonSpeed, latSpeed;
+  QVector<Piece>  lonPieces;          // longitude between the stations, made by findStations()
+  QVector<int>    firstPiece;         // per step, into lonPieces
+
+  int steps() const { return jd.count() - 1; }
+};
+
+static double normalize180 ( double deg )
+ {
+  deg = fmod(deg, 360);
+  if (deg >  180) deg -= 360;
+  if (deg <= -180) deg += 360;
+  return deg;
+ }
+
+static double sampleStep ( const Planet& p )
+ {
+  double speed = qAbs(p.defaultEclipticSpeed.x());
+  return speed > 0 ? qMin(Max_Step, Step_Degrees / speed) : Max_Step;
+ }
+
+static bool sampleTrack ( const Planet& p, double jdFrom, double jdTo, Track& track )
+ {
+  double step   = sampleStep(p);
+  int    n      = qMax(2, (int)ceil((jdTo - jdFrom) / step) + 1);
+  int    flags  = p.sweFlags & ~Planet_InvertPosition;
+  double offset = (p.sweFlags & Planet_InvertPosition) ? 180 : 0;
+  QVector<double> xx(n * 6);
+
+  track.planet = &p;
+  track.jd.resize(n);
+  for (int i = 0; i < n; i++)
+    track.jd[i] = jdFrom + (jdTo - jdFrom) * i / (n - 1);
+
+  if (!chartPositions(p.sweNum, flags, track.jd.constData(), n, xx.data()))
+   {
+    qDebug() << "A: can't sample" << p.name;
+    return false;
+   }
+
+  track.lon.resize(n);
+  track.lat.resize(n);
+  track.lonSpeed.resize(n);
+  track.latSpeed.resize(n);
+  for (int i = 0; i < n; i++)
+   {
+    double lon = xx[6 * i] + offset;
+    if (i) lon = track.lon[i - 1] + normalize180(lon - track.lon[i - 1]);
+    track.lon[i]      = lon;
+    track.lat[i]      = xx[6 * i + 1];
+    track.lonSpeed[i] = xx[6 * i + 3];
+    track.latSpeed[i] = xx[6 * i + 4];
+   }
+
+  return true;
+ }
+
+// cubic Hermite through the samples k and k + 1; u = 0...1
+static void interpolate ( const Track& t, int k, double u, Motion& m )
+ {
+  double h  = t.jd[k + 1] - t.jd[k];
+  double u2 = u * u, u3 = u2 * u;
+
+  double h00 = 2 * u3 - 3 * u2 + 1, h10 = u3 - 2 * u2 + u;
+  double h01 = 3 * u2 - 2 * u3,     h11 = u3 - u2;
+  double d00 = 6 * u2 - 6 * u,      d10 = 3 * u2 - 4 * u + 1;
+  double d01 = -d00,                d11 = 3 * u2 - 2 * u;
+
+  m.lon      = h00 * t.lon[k] + h10 * h * t.lonSpeed[k] + h01 * t.lon[k + 1] + h11 * h * t.lonSpeed[k + 1];
+  m.lat      = h00 * t.lat[k] + h10 * h * t.latSpeed[k] + h01 * t.lat[k + 1] + h11 * h * t.latSpeed[k + 1];
+  m.lonSpeed = (d00 * t.lon[k] + d01 * t.lon[k + 1]) / h + d10 * t.lonSpeed[k] + d11 * t.lonSpeed[k + 1];
+  m.latSpeed = (d00 * t.lat[k] + d01 * t.lat[k + 1]) / h + d10 * t.latSpeed[k] + d11 * t.latSpeed[k + 1];
+  m.lonAccel = ((12 * u - 6) * (t.lon[k] - t.lon[k + 1]) / h +
+                (6 * u - 4) * t.lonSpeed[k] + (6 * u - 2) * t.lonSpeed[k + 1]) / h;
+ }
+
+/* A function of the motion of a body and its derivative in time. */
+
+class MotionFunction
+ {
+  public:
+    virtual ~MotionFunction() { }
+    virtual void value ( const Motion& m, double& f, double& df ) const = 0;
+ };
+
+// longitude distance to natalLon + target; wraps at +-180, far from the root
+class LongitudeOffset : public MotionFunction
+ {
+  public:
+    LongitudeOffset ( double natalLon, double target ) : point(natalLon + target) { }
+    void value ( const Motion& m, double& f, double& df ) const
+     {
+      f  = normalize180(m.lon - point);
+      df = m.lonSpeed;
+     }
+
+  private:
+    double point;
+ };
+
+// the angle of angle(const Planet&, QPointF)
+class AspectAngle : public MotionFunction
+ {
+  public:
+    AspectAngle ( QPointF natal ) : lon(natal.x()), lat(natal.y()) { }
+    void value ( const Motion& m, double& f, double& df ) const
+     {
+      double s  = normalize180(m.lon - lon);
+      double a  = fabs(s);
+      double b  = m.lat - lat;
+      double da = s < 0 ? -m.lonSpeed : m.lonSpeed;
+      f  = sqrt(a * a + b * b);
+      df = f > 0 ? (a * da + b * m.latSpeed) / f : 0;
+     }
+
+  private:
+    double lon, lat;
+ };
+
+class LongitudeSpeed : public MotionFunction
+ {
+  public:
+    void value ( const Motion& m, double& f, double& df ) const
+     {
+      f  = m.lonSpeed;
+      df = m.lonAccel;
+     }
+ };
+
+static void functionAt ( const Track& t, int k, const MotionFunction& fn, double u, double& f, double& df )
+ {
+  Motion m;
+  interpolate(t, k, u, m);
+  fn.value(m, f, df);
+ }
+
+// splits step k at a turning point of fn, where its derivative changes sign;
+// returns the number of pieces, 1 or 2
+static int monotonePieces ( const Track& t, int k, const MotionFunction& fn, Piece* pieces )
+ {
+  double f0, df0, f1, df1;
+  functionAt(t, k, fn, 0, f0, df0);
+  functionAt(t, k, fn, 1, f1, df1);
+
+  pieces[0].u0 = 0; pieces[0].f0 = f0;
+  pieces[0].u1 = 1; pieces[0].f1 = f1;
+  if ((df0 < 0) == (df1 < 0) || df0 == 0 || df1 == 0) return 1;
+
+  double a = 0, b = 1, f, df;
+  for (int i = 0; i < Bisections; i++)
+   {
+    double c = (a + b) / 2;
+    functionAt(t, k, fn, c, f, df);
+    if ((df < 0) == (df0 < 0)) a = c; else b = c;
+   }
+
+  double turn = (a + b) / 2;
+  functionAt(t, k, fn, turn, f, df);
+  pieces[0].u1 = pieces[1].u0 = turn;
+  pieces[0].f1 = pieces[1].f0 = f;
+  pieces[1].u1 = 1;
+  pieces[1].f1 = f1;
+  return 2;
+ }
+
+static bool crosses ( const Piece& p, double level )
+ {
+  return (p.f0 < level && p.f1 >= level) || (p.f0 > level && p.f1 <= level);
+ }
+
+// time where fn crosses level within the piece: Newton steps on the curve,
+// bisection where they leave the bracket
+static double crossing ( const Track& t, int k, const MotionFunction& fn, const Piece& p, double level )
+ {
+  double h = t.jd[k + 1] - t.jd[k];
+  double a = p.u0, b = p.u1, f, df;
+  bool rising = p.f1 > p.f0;
+  double u = a + (b - a) * (level - p.f0) / (p.f1 - p.f0);
+
+  for (int i = 0; i < Max_Iterations && b - a > Precision / h; i++)
+   {
+    functionAt(t, k, fn, u, f, df);
+    if ((f < level) == rising) a = u; else b = u;
+
+    double next = df ? u - (f - level) / (df * h) : a;
+    if (qAbs(next - u) < Precision / h) { u = next; break; }
+    u = (next > a && next < b) ? next : (a + b) / 2;
+   }
+
+  return t.jd[k] + qBound(p.u0, u, p.u1) * h;
+ }
+
+
+static TransitEvent& addEvent ( TransitEventList& events, double jd, TransitEventType type, const Track& t )
+ {
+  TransitEvent e;
+  e.jd   = jd;
+  e.type = type;
+  e.body = t.planet->id;
+  events << e;
+  return events.last();
+ }
+
+static void addAspect ( TransitEventList& events, double jd, TransitEventType type, const Track& t,
+                        const Planet& natal, const AspectType& aspect )
+ {
+  TransitEvent& e = addEvent(events, jd, type, t);
+  e.natal  = natal.id;
+  e.aspect = &aspect;
+ }
+
+// stations, and the pieces of monotonic longitude they split the steps into
+static void findStations ( Track& t, TransitEventList& events )
+ {
+  LongitudeSpeed speed;
+  Piece  pieces[2];
+  Motion m;
+
+  t.lonPieces.clear();
+  t.firstPiece.resize(t.steps() + 1);
+
+  for (int k = 0; k < t.steps(); k++)
+   {
+    t.firstPiece[k] = t.lonPieces.count();
+    Piece lon = { 0, 1, t.lon[k], t.lon[k + 1] };
+
+    if ((t.lonSpeed[k] < 0) != (t.lonSpeed[k + 1] < 0))
+     {
+      int n = monotonePieces(t, k, speed, pieces);
+      for (int i = 0; i < n; i++)
+        if (crosses(pieces[i], 0))
+         {
+          double jd = crossing(t, k, speed, pieces[i], 0);
+          addEvent(events, jd, Transit_Station, t).retrograde = pieces[i].f1 < 0;
+
+          lon.u1 = (jd - t.jd[k]) / (t.jd[k + 1] - t.jd[k]);
+          interpolate(t, k, lon.u1, m);
+          lon.f1 = m.lon;
+          t.lonPieces << lon;
+          lon.u0 = lon.u1;
+          lon.f0 = lon.f1;
+          lon.u1 = 1;
+          lon.f1 = t.lon[k + 1];
+         }
+     }
+
+    t.lonPieces << lon;
+   }
+
+  t.firstPiece[t.steps()] = t.lonPieces.count();
+ }
+
+struct Crossing
+{
+  int    k;                           // step
+  double jd;
+  bool   direct;                      // longitude increases
+};
+
+// times the longitude of the track passes point (mod 360)
+static void findLongitude ( const Track& t, double point, QVector<Crossing>& found )
+ {
+  LongitudeOffset offset(point, 0);
+  found.clear();
+
+  // the offset follows the track and is kept within +-180; it wraps far from its root
+  double step = normalize180(t.lon[0] - point);
+  for (int k = 0; k < t.steps(); k++)
+   {
+    for (int i = t.firstPiece[k]; i < t.firstPiece[k + 1]; i++)
+     {
+      Piece p = t.lonPieces[i];
+      p.f0 = step + p.f0 - t.lon[k];
+      p.f1 = step + p.f1 - t.lon[k];
+      if (!crosses(p, 0) || qAbs(p.f0) > 90) continue;
+
+      Crossing c = { k, crossing(t, k, offset, p, 0), p.f1 > p.f0 };
+      found << c;
+     }
+
+    step += t.lon[k + 1] - t.lon[k];
+    if (step >   180) step -= 360;
+    if (step <= -180) step += 360;
+   }
+ }
+
+static void findAspects ( const Track& t, const Planet& natal, const AspectsSet& aspectSet,
+                          TransitEventList& events )
+ {
+  AspectAngle angle(natal.eclipticPos);
+  QVector<Crossing> found;
+  Piece  pieces[2];
+  Motion m;
+  double f, df;
+
+  foreach (const AspectType& asp, aspectSet.aspects)
+   {
+    int targets = (asp.angle == 0 || asp.angle == 180) ? 1 : 2;
+    for (int j = 0; j < targets; j++)
+     {
+      findLongitude(t, natal.eclipticPos.x() + (j ? -asp.angle : asp.angle), found);
+
+      foreach (const Crossing& c, found)
+       {
+        interpolate(t, c.k, (c.jd - t.jd[c.k]) / (t.jd[c.k + 1] - t.jd[c.k]), m);
+        angle.value(m, f, df);
+        if (qAbs(f - asp.angle) <= asp.orb)
+          addAspect(events, c.jd, Transit_Exact, t, natal, asp);
+       }
+     }
+   }
+
+  for (int k = 0; k < t.steps(); k++)
+   {
+    int n = monotonePieces(t, k, angle, pieces);
+    for (int i = 0; i < n; i++)
+     {
+      const Piece& p = pieces[i];
+      bool rising = p.f1 > p.f0;
+
+      foreach (const AspectType& asp, aspectSet.aspects)
+       {
+        double inner = asp.angle - asp.orb;
+        double outer = asp.angle + asp.orb;
+
+        if (inner > 0 && crosses(p, inner))
+          addAspect(events, crossing(t, k, angle, p, inner), rising ? Transit_Enter : Transit_Leave,
+                    t, natal, asp);
+        if (crosses(p, outer))
+          addAspect(events, crossing(t, k, angle, p, outer), rising ? Transit_Leave : Transit_Enter,
+                    t, natal, asp);
+       }
+     }
+   }
+ }
+
+// sign ingresses into the signs of the zodiac and crossings of the house cusps
+static void findIngresses ( const Track& t, const Zodiac& zodiac, const Houses& houses, TransitEventList& events )
+ {
+  QVector<Crossing> found;
+
+  foreach (const ZodiacSign& sign, zodiac.signs)
+   {
+    findLongitude(t, sign.startAngle, found);
+    foreach (const Crossing& c, found)       // retrograde: into the sign that ends here
+      addEvent(events, c.jd, Transit_Ingress, t).sign =
+          c.direct ? sign.id : getSign(roundDegree(sign.startAngle - 1e-3), zodiac).id;
+   }
+
+  for (int i = 0; i < 12; i++)
+   {
+    findLongitude(t, houses.cusp[i], found);
+    foreach (const Crossing& c, found)
+      addEvent(events, c.jd, Transit_Cusp, t).house = c.direct ? i + 1 : (i + 11) % 12 + 1;
+   }
+ }
+
+static bool earlier ( const TransitEvent& e1, const TransitEvent& e2 )
+ {
+  return e1.jd < e2.jd;
+ }
+
+TransitEventList findTransits ( const Horoscope& natal, double jdFrom, double jdTo, const AspectsSet& aspectSet )
+ {
+  return findTransits(natal, jdFrom, jdTo, aspectSet, getPlanets());
+ }
+
+TransitEventList findTransits ( const Horoscope& natal, double jdFrom, double jdTo, const AspectsSet& aspectSet,
+                                const QList<PlanetId>& bodies )
+ {
+  TransitEventList ret;
+  if (jdTo <= jdFrom) return ret;
+  attachEphemeris();
+
+  Track track;
+  foreach (PlanetId id, bodies)
+   {
+    if (!sampleTrack(getPlanet(id), jdFrom, jdTo, track)) continue;
+
+    findStations(track, ret);
+    foreach (const Planet& p, natal.planets)
+      findAspects(track, p, aspectSet, ret);
+   }
+
+  qStableSort(ret.begin(), ret.end(), earlier);
+  return ret;
+ }
+
+TransitEventList findIngresses ( const Horoscope& natal, double jdFrom, double jdTo )
+ {
+  return findIngresses(natal, jdFrom, jdTo, getPlanets());
+ }
+
+TransitEventList findIngresses ( const Horoscope& natal, double jdFrom, double jdTo, const QList<PlanetId>& bodies )
+ {
+  TransitEventList ret;
+  if (jdTo <= jdFrom) return ret;
+  attachEphemeris();
+
+  Track track;
+  foreach (PlanetId id, bodies)
+   {
+    if (!sampleTrack(getPlanet(id), jdFrom, jdTo, track)) continue;
+
+    findStations(track, ret);
+    findIngresses(track, natal.zodiac, natal.houses, ret);
+   }
+
+  qStableSort(ret.begin(), ret.end(), earlier);
+  return ret;
+ }
+
+}
@@ -0,0 +1,86 @@
+#include <swephexp.h>
+#undef MSDOS     // undef macroses that made by SWE library
+#undef UCHAR
+#undef forward
+
+#include <math.h>
+#include <QThreadStorage>
+#include "astro-time.h"
+
+namespace A {
+
+const int Cached_Days = 1024;        // per thread, direct mapped by day
+
+
+class DeltaTCache
+ {
+  public:
+    DeltaTCache ( )
+     {
+      for (int i = 0; i < Cached_Days; i++)
+        day[i] = Empty;
+     }
+
+    double deltaT ( double jd )
+     {
+      double start = floor(jd - 0.5);          // the day begins at 0h UT, jd x.5
+      int    d     = (int)start;
+      double dt0   = atDay(d);
+      return dt0 + (atDay(d + 1) - dt0) * (jd - 0.5 - start);
+     }
+
+  private:
+    static const int Empty = -0x7FFFFFFF;
+    int    day [Cached_Days];
+    double dt  [Cached_Days];
+
+    double atDay ( int d )
+     {
+      int i = d & (Cached_Days - 1);
+      if (day[i] != d)
+       {
+        day[i] = d;
+        dt[i]  = swe_deltat(d + 0.5);
+       }
+      return dt[i];
+     }
+ };
+
+static DeltaTCache& deltaTCache ( )
+ {
+  static QThreadStorage<DeltaTCache*> cache;
+  if (!cache.hasLocalData())
+    cache.setLocalData(new DeltaTCache);
+  return *cache.localData();
+ }
+
+double julianDay ( const QDateTime& GMT )
+ {
+  const QTime t = GMT.time();
+  qint64 seconds = GMT.date().toJulianDay() * 86400 - 43200     // the julian day begins at noon
+                 + t.hour() * 3600 + t.minute() * 60 + t.second();
+  return seconds / 86400.0;
+ }
+
+double deltaT ( double jd )
+ {
+  return deltaTCache().deltaT(jd);
+ }
+
+void julianDays ( const QDateTime* GMT, int n, double* ut, double* tt )
+ {
+  for (int i = 0; i < n; i++)
+    ut[i] = julianDay(GMT[i]);
+
+  if (tt)
+    terrestrialTimes(ut, n, tt);
+ }
+
+void terrestrialTimes ( const double* jd, int n, double* tt )
+ {
+  DeltaTCache& cache = deltaTCache();
+  for (int i = 0; i < n; i++)
+    tt[i] = jd[i] + cache.deltaT(jd[i]);
+ }
+
+}
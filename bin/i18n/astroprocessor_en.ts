@@ -298,17 +298,7 @@
     </message>
     <message>
         <location filename="../../astroprocessor/src/astro-output.cpp" line="422"/>
-        <source>+6: Planet is in conjunction with Regulus</source>
-        <translation></translation>
-    </message>
-    <message>
-        <location filename="../../astroprocessor/src/astro-output.cpp" line="425"/>
-        <source>+5: Planet is in conjunction with Spica</source>
-        <translation></translation>
-    </message>
-    <message>
-        <location filename="../../astroprocessor/src/astro-output.cpp" line="428"/>
-        <source>-5: Planet is in conjunction with Algol</source>
+        <source>%1: Planet is in conjunction with %2</source>
         <translation></translation>
     </message>
     <message>
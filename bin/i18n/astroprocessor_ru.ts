@@ -301,18 +301,8 @@
     </message>
     <message>
         <location filename="../../astroprocessor/src/astro-output.cpp" line="422"/>
-        <source>+6: Planet is in conjunction with Regulus</source>
-        <translation>+6: Планета в соединении со звездой Регул</translation>
-    </message>
-    <message>
-        <location filename="../../astroprocessor/src/astro-output.cpp" line="425"/>
-        <source>+5: Planet is in conjunction with Spica</source>
-        <translation>+5: Планета в соединении со звездой Спика</translation>
-    </message>
-    <message>
-        <location filename="../../astroprocessor/src/astro-output.cpp" line="428"/>
-        <source>-5: Planet is in conjunction with Algol</source>
-        <translation>-5: Планета в соединении со звездой Алголь</translation>
+        <source>%1: Planet is in conjunction with %2</source>
+        <translation>%1: Планета в соединении со звездой %2</translation>
     </message>
     <message>
         <location filename="../../astroprocessor/src/astro-output.cpp" line="472"/>
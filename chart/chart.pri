@@ -1,7 +1,14 @@
 TRANSLATIONS = ../bin/i18n/chart_ru.ts \
                ../bin/i18n/chart_en.ts
 			   
-SOURCES += src/chart.cpp
-HEADERS += src/chart.h
+QT += svg
+
+SOURCES += src/chart.cpp \
+           src/pngwriter.cpp
+HEADERS += src/chart.h \
+           src/pngwriter.h
+
+unix:  LIBS += -lz
+win32: QT += zlib-private                # zlib bundled with Qt
 
 INCLUDEPATH += ../astroprocessor/include/
\ No newline at end of file
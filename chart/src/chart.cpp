@@ -4,44 +4,287 @@
 #include <QGraphicsSceneMouseEvent>
 #include <QWheelEvent>
 #include <QGraphicsDropShadowEffect>
+#include <QCache>
+#include <QMutex>
+#include <QFileInfo>
+#include <QSvgGenerator>
+#include <QPdfWriter>
+#include <QImageWriter>
+#include <QPaintEngine>
+#include <QThread>
+#include <QWaitCondition>
 #include <QDebug>
 #include <math.h>
 #include <Astroprocessor/Output>
 #include <Astroprocessor/Calc>
 #include "chart.h"
+#include "pngwriter.h"
 
 //Zodiac Server
 #include <QApplication>
 
 
-RotatingCircleItem :: RotatingCircleItem(QRect rect, const QPen& pen) : QAbstractGraphicsShapeItem()
+static bool isVectorDevice(QPainter* p)
+{
+    switch (p->paintEngine()->type())
+    {
+        case QPaintEngine::SVG:
+        case QPaintEngine::Pdf:
+        case QPaintEngine::Picture: return true;
+        default:                    return false;
+    }
+}
+
+class GlyphItem : public QGraphicsSimpleTextItem     // outlines on vector devices: they may lack the font
+{
+    public:
+        GlyphItem(const QString& text, const QFont& font) : QGraphicsSimpleTextItem(text) { setFont(font); }
+
+        void paint(QPainter* p, const QStyleOptionGraphicsItem* option, QWidget* widget)
+        {
+            if (!isVectorDevice(p))
+                return QGraphicsSimpleTextItem::paint(p, option, widget);
+
+            QPainterPath path;
+            path.addText(0, QFontMetricsF(font()).ascent(), font(), text());
+            p->setPen(pen());
+            p->setBrush(brush());
+            p->drawPath(path);
+        }
+};
+
+class ZodiacBandItem : public QGraphicsItem          // carries the shadow effect in ZodiacRing::draw()
+{
+    private:
+        ZodiacRing* ring;
+
+    public:
+        ZodiacBandItem(ZodiacRing* ring) { this->ring = ring; }
+        QRectF boundingRect() const { return ring->circleRect().adjusted(-1, -1, 1, 1); }
+        void paint(QPainter* p, const QStyleOptionGraphicsItem*, QWidget*) { ring->drawBand(p, false); }
+};
+
+
+/* =========================== ZODIAC RING ========================================== */
+
+ZodiacRing :: ZodiacRing(const A::Zodiac& zodiac, const QRectF& rect, float width, const ChartStyle& style)
+{
+    this->zodiac = zodiac;
+    this->rect   = rect;
+    this->width  = width;
+    colored      = style.coloredZodiac;
+    dropShadow   = style.zodiacDropShadow;
+    clockwise    = style.clockwise;
+}
+
+QRectF ZodiacRing :: bounds() const
+{
+    float margin = dropShadow ? width : 0;   // blur radius of the shadow
+    return rect.adjusted(-margin, -margin, margin, margin);
+}
+
+void ZodiacRing :: drawBand(QPainter* p, bool vector)
+{
+    QPen penZodiac(QColor(31,52,93), width);
+    QPen penBorder(QColor(50,145,240));
+    int adjust = penZodiac.width() / 2;
+    QRectF bandRect = rect.adjusted(adjust, adjust, -adjust, -adjust);
+
+    p->save();
+    p->setBrush(Qt::NoBrush);
+
+    if (colored)
+    {
+        QConicalGradient grad1(rect.center(), 180);
+        QColor color;
+
+        foreach (const A::ZodiacSign& sign, zodiac.signs)
+        {
+            color.setNamedColor(sign.userData["bgcolor"].toString());
+            float a1 = sign.startAngle / 360;
+            float a2 = sign.endAngle / 360 - 0.0001;
+
+            if (clockwise)
+            {
+                a1 = 0.5 - a1; if (a1 < 0) a1 += 1;
+                a2 = 0.5 - a2; if (a2 < 0) a2 += 1;
+            }
+
+            grad1.setColorAt(a1, color);
+            grad1.setColorAt(a2, color);
+
+            if (vector)                          // SVG and PDF have no conical gradients: an arc for each sign
+            {
+                float span = sign.endAngle - sign.startAngle;
+                if (span < 0) span += 360;
+                p->setPen(QPen(color, penZodiac.width(), Qt::SolidLine, Qt::FlatCap));
+                p->drawArc(bandRect, (180 + a1 * 360) * 16, (clockwise ? -span : span) * 16);
+            }
+        }
+
+        penZodiac.setBrush(QBrush(grad1));
+        penBorder.setColor(Qt::black);
+    }
+
+    if (!colored || !vector)
+    {
+        p->setPen(penZodiac);
+        p->drawEllipse(bandRect);
+    }
+
+    p->setPen(penBorder);
+    p->drawEllipse(rect);                                                         // zodiac outer border
+    p->drawEllipse(rect.adjusted(width, width, -width, -width));                  // zodiac inner border
+
+    foreach (const A::ZodiacSign& sign, zodiac.signs)
+    {
+        float rad = -sign.startAngle * 3.1416 / 180;
+        if (clockwise) rad = 3.1416 - rad;
+
+        p->drawLine(QPointF( rect.x() * cos(rad),                                 // zodiac sign borders
+                             rect.y() * sin(rad)),
+                    QPointF( (rect.x() + width) * cos(rad),
+                             (rect.y() + width) * sin(rad)));
+    }
+
+    p->restore();
+}
+
+void ZodiacRing :: addBand(QGraphicsScene& s, const QTransform& transform)
+{
+    ZodiacBandItem* band = new ZodiacBandItem(this);
+    band->setTransform(transform);
+    s.addItem(band);
+
+    if (dropShadow)
+    {
+        QGraphicsDropShadowEffect* effect = new QGraphicsDropShadowEffect;
+        effect->setBlurRadius(width);
+        effect->setOffset(0);
+        effect->setColor(QColor(0,0,0,150));
+        band->setGraphicsEffect(effect);
+    }
+}
+
+QImage ZodiacRing :: draw(const QSize& size)
+{
+    qDebug() << "Draw zodiac ring" << zodiac.id << size;
+
+    QGraphicsScene s;
+    s.setItemIndexMethod(QGraphicsScene::NoIndex);
+    addBand(s);
+
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter p(&image);
+    p.setRenderHints(QPainter::Antialiasing);
+    s.render(&p, QRectF(), bounds(), Qt::IgnoreAspectRatio);
+    return image;
+}
+
+QImage ZodiacRing :: draw(const QRect& piece, const QTransform& transform, qreal ratio)
+{
+    int margin = ceil(width) * 2 + 2;        // the shadow of the band around the piece reaches into it
+    QRect area = piece.adjusted(-margin, -margin, margin, margin);
+
+    QGraphicsScene s;
+    s.setItemIndexMethod(QGraphicsScene::NoIndex);
+    addBand(s, transform * QTransform::fromTranslate(-area.x(), -area.y()) * QTransform::fromScale(ratio, ratio));
+
+    QImage image(area.size() * ratio, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter p(&image);
+    p.setRenderHints(QPainter::Antialiasing);
+    s.render(&p, image.rect(), image.rect());
+    p.end();
+
+    image = image.copy(QRect(QPoint(margin, margin) * ratio, piece.size() * ratio));
+    image.setDevicePixelRatio(ratio);
+    return image;
+}
+
+QImage ZodiacRing :: image(const QSize& size)
+{
+    static QCache<QString, QImage> cache(128 * 1024);    // KB, a few zodiacs in a few device sizes
+    static QMutex mutex;
+
+    QString key = QString("%1 %2 %3 %4 %5 %6 %7x%8").arg(zodiac.id).arg(rect.width()).arg(width)
+                     .arg(colored).arg(dropShadow).arg(clockwise).arg(size.width()).arg(size.height());
+
+    QMutexLocker locker(&mutex);                          // tiles of one image are painted on several threads:
+    if (QImage* cached = cache.object(key))               // one draws the ring, the others wait for it
+        return *cached;
+
+    QImage ret = draw(size);
+    cache.insert(key, new QImage(ret), ret.byteCount() / 1024);
+    return ret;
+}
+
+void ZodiacRing :: paint(QPainter* p)
+{
+    if (isVectorDevice(p))
+    {
+        drawBand(p, true);                   // resolution independent
+        return;
+    }
+
+    const QTransform& t = p->worldTransform();
+    float scale = sqrt(t.m11() * t.m11() + t.m12() * t.m12())         // pixels per scene unit, whatever the rotation
+                  * p->device()->devicePixelRatio();
+    QSize size(ceil(bounds().width() * scale), ceil(bounds().height() * scale));
+    if (size.isEmpty()) return;
+
+    qreal ratio   = p->device()->devicePixelRatio();
+    QRect ring    = t.mapRect(bounds()).toAlignedRect();
+    QRect visible = ring & QRect(0, 0, p->device()->width() / ratio, p->device()->height() / ratio);
+    if ((qint64)size.width() * size.height() > cachedPixels && visible != ring)
+    {                                        // tiles of a big image: only the part on the device, not cached
+        if (visible.isEmpty()) return;
+        p->save();
+        p->resetTransform();
+        p->drawImage(visible.topLeft(), draw(visible, t, ratio));
+        p->restore();
+        return;
+    }
+
+    p->save();
+    p->setRenderHint(QPainter::SmoothPixmapTransform);
+    p->drawImage(bounds(), image(size));
+    p->restore();
+}
+
+
+/* =========================== ROTATING CIRCLE ====================================== */
+
+RotatingCircleItem :: RotatingCircleItem(const ZodiacRing& ring) : QAbstractGraphicsShapeItem(), ring(ring)
 {
     file = 0;
-    this->rect = rect;
-    setPen(pen);
 }
 
 void RotatingCircleItem :: paint(QPainter* p, const QStyleOptionGraphicsItem*, QWidget*)
-{                                            // simply draw a circle with assigned pen
-    p->setPen(pen());
-    int adjust = pen().width() / 2;
-    p->drawEllipse(rect.adjusted(adjust, adjust, -adjust, -adjust));
+{                                            // simply draw the prerendered ring
+    ring.paint(p);
 }
 
 QPainterPath RotatingCircleItem :: shape() const
 {                                            // creates a ring shape
+    const QRectF& rect = ring.circleRect();
+    float width = ring.bandWidth();
+
     QPainterPath path;
-    path.addEllipse(boundingRect());
+    path.addEllipse(rect);
 
     QPainterPath innerPath;
-    path.addEllipse(boundingRect().adjusted(pen().width(), pen().width(), -pen().width(), -pen().width()));
+    path.addEllipse(rect.adjusted(width, width, -width, -width));
 
     return path.subtracted(innerPath);
 }
 
 float RotatingCircleItem :: angle(const QPointF& pos)
 {
-    QPointF center = boundingRect().center();
+    QPointF center = ring.circleRect().center();
 
     float ret = atan((pos.y() - center.y()) /
                      (pos.x() - center.x())) * 180 / 3.1416;
@@ -122,82 +365,86 @@ void RotatingCircleItem :: setHelpTag(QGraphicsItem* item, QString tag)
 }
 
 
-/* =========================== ASTRO MAP SHOW ======================================= */
+/* =========================== CHART SCENE ========================================== */
 
-Chart :: Chart(QWidget *parent) : AstroFileHandler(parent)
+ChartStyle :: ChartStyle()
 {
-    chartsCount = 0;
-    zoom = 1;
+    circleStart      = Start_Ascendent;
+    clockwise        = false;
+    zodiacWidth      = 36;
+    cuspideLength    = 36;
+    innerRadius      = 130;
+    coloredZodiac    = true;
+    zodiacDropShadow = true;
+    background       = Qt::black;
+}
 
-    float scale = 0.75;
-    viewport = QRect(chartRect().x() / scale, chartRect().y() / scale, chartRect().width() / scale, chartRect().height() / scale);
+bool ChartStyle :: operator==(const ChartStyle& other) const
+{
+    return circleStart      == other.circleStart      &&
+           clockwise        == other.clockwise        &&
+           zodiacWidth      == other.zodiacWidth      &&
+           cuspideLength    == other.cuspideLength    &&
+           innerRadius      == other.innerRadius      &&
+           coloredZodiac    == other.coloredZodiac    &&
+           zodiacDropShadow == other.zodiacDropShadow &&
+           background       == other.background;
+}
 
-    view = new QGraphicsView(this);
+ChartStyle :: ChartStyle(const AppSettings& s)
+{
+    ChartStyle d;
+    circleStart      = (CircleStart)s.value("Circle/circleStart", d.circleStart).toInt();
+    clockwise        = s.value ( "Circle/clockwise",        d.clockwise        ).toBool();
+    zodiacWidth      = s.value ( "Circle/zodiacWidth",      d.zodiacWidth      ).toInt();
+    cuspideLength    = s.value ( "Circle/cuspideLength",    d.cuspideLength    ).toInt();
+    innerRadius      = s.value ( "Circle/innerRadius",      d.innerRadius      ).toInt();
+    coloredZodiac    = s.value ( "Circle/coloredZodiac",    d.coloredZodiac    ).toBool();
+    zodiacDropShadow = s.value ( "Circle/zodiacDropShadow", d.zodiacDropShadow ).toBool();
+    background       = d.background;
+}
 
-    view->setScene(new QGraphicsScene());
-    view->setRenderHints(QPainter::Antialiasing|QPainter::TextAntialiasing);
-    //view->installEventFilter(this);
-    view->scene()->installEventFilter(this);
-    view->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-    view->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+ChartScene :: ChartScene()
+{
+    s = new QGraphicsScene();
+    s->setItemIndexMethod(QGraphicsScene::NoIndex);   // few items; nothing is left for an event loop to update
+    zoom = 1;
+    chartsCount = 0;
+    circle = 0;
+    builtZoom = 0;
+    builtZodiac = A::Zodiac_None;
+    aspectsCount = 0;
+}
 
-    QVBoxLayout* layout = new QVBoxLayout(this);
-    layout->setMargin(0);
-    layout->addWidget(view);
+ChartScene :: ~ChartScene()
+{
+    delete s;
+}
 
-    //Zodiac Server
-    if(qApp->applicationFilePath().indexOf("zodiac_server")>0){
-        view->setObjectName("chartview");
-        view->setStyleSheet("#chartview{background-color: #000}");
-    }
+QRect ChartScene :: chartRect()
+{
+    return QRect(-defaultChartRadius * zoom, -defaultChartRadius * zoom,
+                 defaultChartRadius * 2 * zoom, defaultChartRadius * 2 * zoom);
 }
 
-void Chart :: fitInView()
+QRectF ChartScene :: defaultViewport()
 {
-    //QRect rect(chartRect.x() / zoom, chartRect.y() / zoom, chartRect.width() / zoom, chartRect.height() / zoom);
-    view->fitInView(viewport, Qt::KeepAspectRatio);
+    float scale = 0.75;
+    return QRectF(chartRect().x() / scale, chartRect().y() / scale, chartRect().width() / scale, chartRect().height() / scale);
 }
 
-void Chart :: createScene()
+void ChartScene :: createScene()
 {
     qDebug() << "Create scene";
-    QGraphicsScene* s = view->scene();
 
     QBrush background(QColor(8, 103, 192, 50));
-    QPen penZodiac(QColor(31,52,93), zodiacWidth());
-    QPen penBorder(QColor(50,145,240));
+    QPen penBorder(st.coloredZodiac ? Qt::black : QColor(50,145,240));
     QPen penCircle(QColor(227,214,202), 1);
     QFont zodiacFont("Almagest", 16 * zoom, QFont::Bold);
     QColor signFillColor = Qt::black;
     QColor signShapeColor = "#6d6d6d";
 
-    if (coloredZodiac)
-    {
-        QConicalGradient grad1(chartRect().center(), 180);
-        QColor color;
-
-        foreach (const A::ZodiacSign& sign, file()->horoscope().zodiac.signs)
-        {
-            color.setNamedColor(sign.userData["bgcolor"].toString());
-            float a1 = sign.startAngle / 360;
-            float a2 = sign.endAngle / 360 - 0.0001;
-
-            if (clockwise)
-            {
-                a1 = 0.5 - a1; if (a1 < 0) a1 += 1;
-                a2 = 0.5 - a2; if (a2 < 0) a2 += 1;
-            }
-
-            grad1.setColorAt(a1, color);
-            grad1.setColorAt(a2, color);
-        }
-
-        penZodiac.setBrush(QBrush(grad1));
-        penBorder.setColor(Qt::black);
-
-    }
-
-    for (int f = 0; f < filesCount(); f++)
+    for (int f = 0; f < charts.count(); f++)
     {                                                                            // inner circles
         s->addEllipse(-innerRadius(f), -innerRadius(f), 2 * innerRadius(f), 2 * innerRadius(f), penCircle);
         drawCuspides(f);                                                            // cuspides
@@ -205,45 +452,22 @@ void Chart :: createScene()
 
     s->addEllipse(chartRect().adjusted(2,2,-2,-2), penBorder, background);        // fill background (with margin)
 
-    circle = new RotatingCircleItem(chartRect(), penZodiac);                      // zodiac circle
-    circle->setCursor(QPixmap("chart/rotate.png"));
+    circle = new RotatingCircleItem(ZodiacRing(charts.at(0).zodiac,               // zodiac circle
+                                               chartRect(), zodiacWidth(), st));
     s->addItem(circle);
-    s->addEllipse(chartRect(), penBorder)->setParentItem(circle);                 // zodiac outer border
-    s->addEllipse(chartRect().adjusted(zodiacWidth(), zodiacWidth(),              // zodiac inner border
-                                       -zodiacWidth(), -zodiacWidth()), penBorder)->setParentItem(circle);
-
-    if (zodiacDropShadow)
-    {
-        QGraphicsDropShadowEffect* effect = new QGraphicsDropShadowEffect;
-        effect->setBlurRadius(zodiacWidth());
-        effect->setOffset(0);
-        effect->setColor(QColor(0,0,0,150));
-        circle->setGraphicsEffect(effect);
-    }
 
-    foreach (const A::ZodiacSign& sign, file()->horoscope().zodiac.signs)
+    foreach (const A::ZodiacSign& sign, charts.at(0).zodiac.signs)
     {
         float endAngle = sign.endAngle;
         if (sign.startAngle > endAngle) endAngle += 360;
-        float rad = -sign.startAngle * 3.1416 / 180;
         float rad_mid = -(sign.startAngle + (endAngle - sign.startAngle) / 2) * 3.1416 / 180;
-
-        if (clockwise)
-        {
-            rad     = 3.1416 - rad;
-            rad_mid = 3.1416 - rad_mid;
-        }
-
-        s->addLine( chartRect().x() * cos(rad),                               // zodiac sign borders
-                    chartRect().y() * sin(rad),
-                    (chartRect().x() + zodiacWidth()) * cos(rad),
-                    (chartRect().y() + zodiacWidth()) * sin(rad), penBorder)->setParentItem(circle);
+        if (st.clockwise) rad_mid = 3.1416 - rad_mid;
 
         QString ch = QString(sign.userData["fontChar"].toInt());
-        QGraphicsSimpleTextItem* text = s->addSimpleText(ch, zodiacFont); // zodiac sign icon
+        QGraphicsSimpleTextItem* text = addText(ch, zodiacFont);           // zodiac sign icon
         text->setParentItem(circle);
-        text->setBrush(coloredZodiac ? signFillColor  : sign.userData["fillColor"].toString());
-        text->setPen  (coloredZodiac ? signShapeColor : sign.userData["shapeColor"].toString());
+        text->setBrush(st.coloredZodiac ? signFillColor  : sign.userData["fillColor"].toString());
+        text->setPen  (st.coloredZodiac ? signShapeColor : sign.userData["shapeColor"].toString());
         text->setOpacity(0.9);
         text->moveBy((chartRect().x() + zodiacWidth() / 2) * cos(rad_mid) - text->boundingRect().width() / 2,
                      (chartRect().y() + zodiacWidth() / 2) * sin(rad_mid) - text->boundingRect().height() / 2);
@@ -252,25 +476,46 @@ void Chart :: createScene()
         signIcons << text;
     }
 
-    for(int i = 0; i < filesCount(); i++)
+    builtPlanets.clear();
+    for(int i = 0; i < charts.count(); i++)
+    {
         drawPlanets(i);
+        builtPlanets << charts.at(i).planets.keys();
+    }
 
-    /*if (viewport.center() != QPointF(0,0)) */fitInView();
-    chartsCount = filesCount();
+    chartsCount = charts.count();
+    builtStyle  = st;
+    builtZoom   = zoom;
+    builtZodiac = charts.at(0).zodiac.id;
 }
 
-void Chart :: updateScene()
+bool ChartScene :: isOutdated()
+{
+    if (chartsCount != charts.count())
+        return true;
+    if (!chartsCount)
+        return false;
+    if (!(builtStyle == st) || builtZoom != zoom || builtZodiac != charts.at(0).zodiac.id)
+        return true;
+
+    for (int i = 0; i < charts.count(); i++)                // each planet has its items
+        if (builtPlanets[i] != charts.at(i).planets.keys())
+            return true;
+
+    return false;
+}
+
+void ChartScene :: updateScene()
 {
     qDebug() << "Update scene";
 
-    circle->setFile(file());
     float rotate;
 
-    if (circleStart == Start_Ascendent)
-        rotate = file()->horoscope().houses.cusp[0];
+    if (st.circleStart == Start_Ascendent)
+        rotate = charts.at(0).houses.cusp[0];
     else
-        rotate = file()->horoscope().zodiac.signs[0].startAngle;
-    if (clockwise) rotate = -rotate;
+        rotate = charts.at(0).zodiac.signs[0].startAngle;
+    if (st.clockwise) rotate = -rotate;
 
     foreach (QGraphicsItem* i, signIcons)
         i->setRotation(-rotate);
@@ -278,17 +523,17 @@ void Chart :: updateScene()
     circle->setRotation(rotate);
 }
 
-void Chart :: updatePlanetsAndCusps(int fileIndex)
+void ChartScene :: updatePlanetsAndCusps(int fileIndex)
 {
     qDebug() << "Update planets and cusps" << fileIndex;
 
     float rotate = circle->rotation();
-    foreach (const A::Planet& p, file(fileIndex)->horoscope().planets) // update planets
+    foreach (const A::Planet& p, charts.at(fileIndex).planets)         // update planets
     {
         QGraphicsItem* marker = planetMarkers[fileIndex][p.id];
         QGraphicsItem* planet = planets[fileIndex][p.id];
         float angle = p.eclipticPos.x();
-        if (clockwise) angle = 180 - angle;
+        if (st.clockwise) angle = 180 - angle;
 
 
         planet -> setPos(normalPlanetPosX(planet, marker),planet->pos().y());
@@ -303,7 +548,7 @@ void Chart :: updatePlanetsAndCusps(int fileIndex)
         }
 
         QString toolTip = QString("%1 %2, %3").arg(p.name)
-                .arg(A::zodiacPosition(p, file()->horoscope().zodiac, A::HighPrecision))
+                .arg(A::zodiacPosition(p, charts.at(0).zodiac, A::HighPrecision))
                 .arg(A::houseNum(p));
         planet -> setToolTip(toolTip);
         marker -> setToolTip(toolTip);
@@ -313,8 +558,8 @@ void Chart :: updatePlanetsAndCusps(int fileIndex)
 
     for (int i = 0; i < 12; i++)                           // update cuspides && labels
     {
-        float cusp = file(fileIndex)->horoscope().houses.cusp[i];
-        if (clockwise) cusp = 180 - cusp;
+        float cusp = charts.at(fileIndex).houses.cusp[i];
+        if (st.clockwise) cusp = 180 - cusp;
 
         QGraphicsItem* c = cuspides[fileIndex][i];
         QGraphicsItem* l = cuspideLabels[fileIndex][i];
@@ -322,36 +567,39 @@ void Chart :: updatePlanetsAndCusps(int fileIndex)
         c->setRotation(-cusp + rotate);
         l->setRotation(cusp - rotate);
 
-        QString tag = tr("%1+%2").arg(A::romanNum(i+1))
-                .arg(A::getSign(cusp, file()->horoscope().zodiac).name);
+        QString tag = QCoreApplication::translate("Chart", "%1+%2").arg(A::romanNum(i+1))
+                .arg(A::getSign(cusp, charts.at(0).zodiac).name);
         circle->setHelpTag(c, tag);
         circle->setHelpTag(l, tag);
 
-        c->setToolTip(tr("House %1\n%2").arg(A::romanNum(i+1))
-                      .arg(A::zodiacPosition(cusp, file()->horoscope().zodiac)));
+        c->setToolTip(QCoreApplication::translate("Chart", "House %1\n%2").arg(A::romanNum(i+1))
+                      .arg(A::zodiacPosition(cusp, charts.at(0).zodiac)));
         l->setToolTip(c->toolTip());
     }
 }
 
-void Chart :: updateAspects()
+void ChartScene :: updateAspects()
 {
     int i = 0;
-    const A::AspectList& list = (filesCount() == 1 ? file()->horoscope().aspects : calculateSynastryAspects());
+    const A::AspectList& list = (charts.count() == 1 ? charts.at(0).aspects :
+                                 A::calculateAspects(A::getAspectSet(charts.at(0).inputData.aspectSet),   // synastry
+                                                     charts.at(0).planets, charts.at(1).planets));
     foreach (const A::Aspect& asp, list)
     {
         QLineF line(getCircleMarker(asp.planet1)->sceneBoundingRect().center(),
                     getCircleMarker(asp.planet2)->sceneBoundingRect().center());
 
         if (i >= aspects.count())                 // add or change geometry
-            aspects << view->scene()->addLine(line, aspectPen(asp));
+            aspects << s->addLine(line, aspectPen(asp));
         else
         {
             aspects[i]->setLine(line);
             aspects[i]->setPen(aspectPen(asp));
+            aspects[i]->show();
         }
 
         QString toolTip;
-        if (filesCount() > 1)
+        if (charts.count() > 1)
             toolTip = A::describeAspectFull(asp, "#1", "#2");
         else
             toolTip = A::describeAspectFull(asp);
@@ -367,45 +615,237 @@ void Chart :: updateAspects()
         i++;
     }
 
-    while (i != aspects.count())     // remove unused aspect items
-    {
-        view->scene()->removeItem(aspects.takeLast());
-        //aspectMarkers.removeLast();
-    }
+    aspectsCount = i;
+    for (; i < aspects.count(); i++)    // hide unused aspect items, next charts will take them
+        aspects[i]->hide();
 }
 
-void Chart :: clearScene()
+void ChartScene :: clearScene()
 {
     qDebug() << "Clear scene";
-    view->scene()->clear();
+    s->clear();
     chartsCount = 0;
+    circle = 0;
     cuspides.clear();
     cuspideLabels.clear();
     planets.clear();
     planetMarkers.clear();
     aspects.clear();
+    aspectsCount = 0;
     //aspectMarkers.clear();
     signIcons.clear();
 }
 
-QRect Chart :: chartRect()
+void ChartScene :: build()
 {
-    return QRect(-defaultChartRadius * zoom, -defaultChartRadius * zoom,
-                 defaultChartRadius * 2 * zoom, defaultChartRadius * 2 * zoom);
+    if (chartsCount && isOutdated())
+        clearScene();
+    if (!charts.count()) return;
+    if (!chartsCount)
+        createScene();
+
+    updateScene();
+    for (int i = 0; i < charts.count(); i++)
+        updatePlanetsAndCusps(i);
+    updateAspects();
+}
+
+void ChartScene :: render(QPainter* p, const QRectF& target, QRectF viewport)
+{
+    if (viewport.isNull()) viewport = defaultViewport();
+
+    p->fillRect(target, st.background);
+    p->setRenderHints(QPainter::Antialiasing|QPainter::TextAntialiasing);
+    s->render(p, target, viewport, Qt::KeepAspectRatio);       // centered, like QGraphicsView::fitInView()
+}
+
+QImage ChartScene :: render(const QSize& size, QRectF viewport)
+{
+    QImage image(size, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);             // seen through a translucent background
+    QPainter p(&image);
+    render(&p, image.rect(), viewport);
+    return image;
+}
+
+bool ChartScene :: save(const QString& fileName, const QSize& size, QByteArray format, int compression)
+{
+    if (format.isEmpty())
+        format = QFileInfo(fileName).suffix().toLower().toLatin1();
+
+    if (format == "svg")                     // size only sets the aspect and the default size of the drawing
+    {
+        QSvgGenerator svg;
+        svg.setFileName(fileName);
+        svg.setSize(size);
+        svg.setViewBox(QRect(QPoint(0,0), size));
+
+        QPainter p;
+        if (!p.begin(&svg)) return false;
+        render(&p, svg.viewBox());
+        return p.end();
+    }
+    else if (format == "pdf")                // a page of size points
+    {
+        QPdfWriter pdf(fileName);
+        pdf.setPageSize(QPageSize(QSizeF(size), QPageSize::Point));
+        pdf.setPageMargins(QMarginsF(0,0,0,0));
+        pdf.setResolution(72);
+
+        QPainter p;
+        if (!p.begin(&pdf)) return false;
+        render(&p, QRectF(QPointF(0,0), size));
+        return p.end();
+    }
+    else if (format == "png" && (qint64)size.width() * size.height() > tiledPixels)
+    {
+        return saveTiled(fileName, size, compression);
+    }
+
+    QImageWriter writer(fileName, format);
+    if (compression >= 0 && format == "png")
+        writer.setQuality(100 - (compression * 91 + 8) / 9);   // Qt maps quality 0...100 to zlib levels 9...0
+    return writer.write(render(size));
 }
 
-float Chart :: innerRadius(int fileIndex)
+struct TileJob                               // shared by the threads of ChartScene::saveTiled()
+{
+    QList<A::Horoscope> charts;
+    ChartStyle style;
+    float zoom;
+    QRectF viewport;
+    QSize size;
+    int tileHeight;
+    int tiles;
+    int compression;
+    bool alpha;
+
+    QMutex mutex;
+    QWaitCondition changed;
+    int next;                                // tile to render next
+    int written;                             // tiles written to the file
+    int ahead;                               // rendered tiles waiting for the file, at most
+    bool cancel;
+    QMap<int, PngWriter::Band> bands;
+};
+
+class TileThread : public QThread
 {
-    if (filesCount() == 1) return l_innerRadius * zoom;
-    float meanInnerRadius = l_innerRadius * (1 - filesCount() * 0.1);
-    float r = (defaultChartRadius - l_zodiacWidth - meanInnerRadius) * fileIndex / (filesCount());
+    private:
+        TileJob* job;
+
+    protected:
+        void run()
+        {
+            ChartScene scene;                // a scene is used by one thread only
+            scene.setStyle(job->style);
+            scene.setZoom(job->zoom);
+            scene.setHoroscopes(job->charts);
+            scene.build();
+
+            while (true)
+            {
+                job->mutex.lock();
+                while (!job->cancel && job->next < job->tiles && job->next >= job->written + job->ahead)
+                    job->changed.wait(&job->mutex);
+                int tile = (job->cancel ? job->tiles : job->next++);
+                job->mutex.unlock();
+                if (tile >= job->tiles) return;
+
+                int y = tile * job->tileHeight;
+                QImage image(job->size.width(), qMin(job->tileHeight, job->size.height() - y),
+                             QImage::Format_ARGB32_Premultiplied);
+                image.fill(Qt::transparent);
+                QPainter p(&image);
+                p.translate(0, -y);
+                scene.render(&p, QRectF(QPointF(0,0), job->size), job->viewport);
+                p.end();
+
+                image = image.convertToFormat(job->alpha ? QImage::Format_RGBA8888 : QImage::Format_RGB888);
+                PngWriter::Band band = PngWriter::compress(image, job->compression);
+
+                job->mutex.lock();
+                job->bands[tile] = band;
+                job->changed.wakeAll();
+                job->mutex.unlock();
+            }
+        }
+
+    public:
+        TileThread(TileJob* job) { this->job = job; }
+};
+
+bool ChartScene :: saveTiled(const QString& fileName, const QSize& size, int compression)
+{
+    TileJob job;
+    job.charts      = charts;
+    job.style       = st;
+    job.zoom        = zoom;
+    job.viewport    = defaultViewport();
+    job.size        = size;
+    job.tileHeight  = 256;
+    job.tiles       = (size.height() + job.tileHeight - 1) / job.tileHeight;
+    job.compression = compression;
+    job.alpha       = st.background.alpha() < 255;
+    job.next        = 0;
+    job.written     = 0;
+    job.cancel      = false;
+
+    int threads = qBound(1, QThread::idealThreadCount(), job.tiles);
+    job.ahead = threads * 2;
+    qDebug() << "Save tiled" << fileName << size << job.tiles << "tiles on" << threads << "threads";
+
+    PngWriter png(fileName);
+    bool ok = png.begin(size, job.alpha);
+
+    QList<TileThread*> workers;
+    for (int i = 0; ok && i < threads; i++)
+    {
+        workers << new TileThread(&job);
+        workers.last()->start();
+    }
+
+    job.mutex.lock();
+    while (ok && job.written < job.tiles)    // write tiles in order as they come
+    {
+        if (!job.bands.contains(job.written))
+        {
+            job.changed.wait(&job.mutex);
+            continue;
+        }
+
+        PngWriter::Band band = job.bands.take(job.written);
+        job.mutex.unlock();
+        ok = png.write(band);
+        job.mutex.lock();
+        job.written++;
+        job.changed.wakeAll();
+    }
+    job.cancel = true;
+    job.changed.wakeAll();
+    job.mutex.unlock();
+
+    foreach (TileThread* t, workers)
+    {
+        t->wait();
+        delete t;
+    }
+
+    return png.end() && ok;
+}
+
+float ChartScene :: innerRadius(int fileIndex)
+{
+    if (charts.count() == 1) return st.innerRadius * zoom;
+    float meanInnerRadius = st.innerRadius * (1 - charts.count() * 0.1);
+    float r = (defaultChartRadius - st.zodiacWidth - meanInnerRadius) * fileIndex / (charts.count());
     return (meanInnerRadius + r) * zoom;
 }
 
-int Chart :: cuspideLength(int fileIndex, int cusp)
+int ChartScene :: cuspideLength(int fileIndex, int cusp)
 {
     int k = 0;
-    if (filesCount() > 1)                   // make bigger cuspides for first file and smaller for second file
+    if (charts.count() > 1)                 // make bigger cuspides for first file and smaller for second file
     {
         if (fileIndex == 0)
             k = 20;
@@ -414,31 +854,29 @@ int Chart :: cuspideLength(int fileIndex, int cusp)
     }
 
     if (cusp == 0)
-        return l_cuspideLength * 1.4 + k;
+        return st.cuspideLength * 1.4 + k;
     else if (cusp == 9)
-        return l_cuspideLength * 1.2 + k;
-    return l_cuspideLength + k;
+        return st.cuspideLength * 1.2 + k;
+    return st.cuspideLength + k;
 }
 
-void Chart :: drawPlanets(int fileIndex)
+void ChartScene :: drawPlanets(int fileIndex)
 {
     QFont planetFont("Almagest", 17, QFont::Bold);
     QFont planetFontSmall("Almagest", 15, QFont::Bold);
 
-    QGraphicsScene* s = view->scene();
-
-    foreach(const A::Planet& planet, file(fileIndex)->horoscope().planets)
+    foreach(const A::Planet& planet, charts.at(fileIndex).planets)
     {
         int radius = 2;
         int charIndex = planet.userData["fontChar"].toInt();
 
-        QGraphicsSimpleTextItem* text = s->addSimpleText(QString(charIndex),
-                                                         planet.isReal ? planetFont : planetFontSmall);
+        QGraphicsSimpleTextItem* text = addText(QString(charIndex),
+                                                 planet.isReal ? planetFont : planetFontSmall);
 
         QGraphicsEllipseItem* marker = s->addEllipse(-innerRadius(fileIndex) - radius, -radius,
                                                      radius * 2, radius * 2, planetMarkerPen(planet, fileIndex));
 
-        if (filesCount() > 1)
+        if (charts.count() > 1)
             s->addEllipse(-innerRadius(0) - radius, -radius, radius * 2, radius * 2,       // duplicate on circle
                           planetMarkerPen(planet, fileIndex))->setParentItem(marker);
 
@@ -458,14 +896,13 @@ void Chart :: drawPlanets(int fileIndex)
     }
 }
 
-void Chart :: drawCuspides(int fileIndex)
+void ChartScene :: drawCuspides(int fileIndex)
 {
-    static QPen penCusp(QColor(227,214,202), 2);
-    static QPen penCusp1(QColor(250,90,58), 3);
-    static QPen penCusp10(QColor(210,195,150), 3);
-    static QFont font("Times New Roman", 13, QFont::Bold);
+    static const QPen penCusp(QColor(227,214,202), 2);
+    static const QPen penCusp1(QColor(250,90,58), 3);
+    static const QPen penCusp10(QColor(210,195,150), 3);
+    static const QFont font("Times New Roman", 13, QFont::Bold);
 
-    QGraphicsScene* s = view->scene();
     QGraphicsLineItem* l;
     QPen pen;
     int endPointX;
@@ -481,10 +918,10 @@ void Chart :: drawCuspides(int fileIndex)
         else
             pen = penCusp;
 
-        if (filesCount() > 1 && fileIndex == 1)
+        if (charts.count() > 1 && fileIndex == 1)
             pen.setColor(QColor("#00C0FF"));
 
-        if (filesCount() > 1 && fileIndex == 0)
+        if (charts.count() > 1 && fileIndex == 0)
         {
             l = s->addLine(-innerRadius(0), 0, -innerRadius(1), 0, pen);
             s->addLine(chartRect().x(), 0, endPointX, 0, pen)->setParentItem(l);
@@ -507,8 +944,8 @@ void Chart :: drawCuspides(int fileIndex)
 
         cuspides[fileIndex][i] = l;
 
-        QGraphicsSimpleTextItem* t = s->addSimpleText(A::houseTag(i+1), font);
-        t->setBrush(QColor((filesCount() > 1 && fileIndex == 1) ? "#00C0FF" : "#FFFFFF"));
+        QGraphicsSimpleTextItem* t = addText(A::houseTag(i+1), font);
+        t->setBrush(QColor((charts.count() > 1 && fileIndex == 1) ? "#00C0FF" : "#FFFFFF"));
         t->setOpacity(0.6);
         t->setParentItem(l);
         t->moveBy(endPointX + 5, 5);
@@ -518,48 +955,54 @@ void Chart :: drawCuspides(int fileIndex)
 
 }
 
-int  Chart :: normalPlanetPosX(QGraphicsItem* planet, QGraphicsItem* marker)
+QGraphicsSimpleTextItem* ChartScene :: addText(const QString& text, const QFont& font)
+{
+    QGraphicsSimpleTextItem* item = new GlyphItem(text, font);
+    s->addItem(item);
+    return item;
+}
+
+int  ChartScene :: normalPlanetPosX(QGraphicsItem* planet, QGraphicsItem* marker)
 {
     int indent = 6;
     return marker->boundingRect().x() - planet->boundingRect().width() - indent;
 }
 
-const QPen& Chart :: aspectPen(const A::Aspect& asp)
+static QMap<QString, QPen> aspectPens()
 {
-    static QMap<QString, QPen>pens;
-    if (pens.isEmpty())
-    {
-        pens["--"] = QPen(QBrush(QColor(207,41,33)),  2);
-        pens["-"]  = QPen(QBrush(QColor(230,155,57)), 2);
-        pens["0"]  = QPen(QBrush(QColor(15,114,248)), 2);
-        pens["+"]  = QPen(QBrush(QColor(14,162,98)),  2);
-        pens["++"] = QPen(QBrush(QColor(77,206,113)), 2);
-    }
+    QMap<QString, QPen> pens;
+    pens["--"] = QPen(QBrush(QColor(207,41,33)),  2);
+    pens["-"]  = QPen(QBrush(QColor(230,155,57)), 2);
+    pens["0"]  = QPen(QBrush(QColor(15,114,248)), 2);
+    pens["+"]  = QPen(QBrush(QColor(14,162,98)),  2);
+    pens["++"] = QPen(QBrush(QColor(77,206,113)), 2);
+    return pens;
+}
+
+const QPen& ChartScene :: aspectPen(const A::Aspect& asp)
+{
+    static const QMap<QString, QPen> pens = aspectPens();    // read-only once initialized: scenes may be built on several threads
 
     QString tag = asp.d->userData["good"].toString();
     if (pens.contains(tag))
-        return pens[tag];
+        return *pens.find(tag);
 
-    return pens["0"];
+    return *pens.find("0");
 }
 
-const QPen& Chart :: planetMarkerPen(const A::Planet& p, int fileIndex)
+const QPen& ChartScene :: planetMarkerPen(const A::Planet& p, int fileIndex)
 {
-    static QList<QPen>pens;
-    if (pens.isEmpty())
-    {
-        pens << QPen(QColor("#cee1f2"), 2);
-        pens << QPen(QColor("#00C0FF"), 2);
-    }
+    static const QList<QPen> pens = QList<QPen>() << QPen(QColor("#cee1f2"), 2)
+                                                  << QPen(QColor("#00C0FF"), 2);
 
     return pens[qMin(fileIndex, pens.count() - 1)];
 }
 
-QColor Chart :: planetColor(const A::Planet& p, int fileIndex)
+QColor ChartScene :: planetColor(const A::Planet& p, int fileIndex)
 {
     QColor color (p.userData["color"].toString());
 
-    if (filesCount() > 1 || !color.isValid())
+    if (charts.count() > 1 || !color.isValid())
     {
         if (fileIndex == 0)
             return "#cee1f2";
@@ -570,11 +1013,11 @@ QColor Chart :: planetColor(const A::Planet& p, int fileIndex)
     return color;
 }
 
-QColor Chart :: planetShapeColor(const A::Planet& p, int fileIndex)
+QColor ChartScene :: planetShapeColor(const A::Planet& p, int fileIndex)
 {
     QColor shapeColor (p.userData["shapeColor"].toString());
 
-    if (filesCount() > 1 || !shapeColor.isValid())
+    if (charts.count() > 1 || !shapeColor.isValid())
     {
         if (fileIndex == 0)
             return "#48401d";
@@ -585,10 +1028,10 @@ QColor Chart :: planetShapeColor(const A::Planet& p, int fileIndex)
     return shapeColor;
 }
 
-QGraphicsItem* Chart :: getCircleMarker(const A::Planet* p)
+QGraphicsItem* ChartScene :: getCircleMarker(const A::Planet* p)
 {
-    for (int i = 0; i < filesCount(); i++)
-        if (*p == file(i)->horoscope().planets.value(p->id))
+    for (int i = 0; i < charts.count(); i++)
+        if (*p == charts.at(i).planets.value(p->id))
         {
             if (i == 0)
                 return planetMarkers[i][p->id];                   // return marker itself
@@ -599,24 +1042,99 @@ QGraphicsItem* Chart :: getCircleMarker(const A::Planet* p)
     return 0;
 }
 
+
+/* =========================== ASTRO MAP SHOW ======================================= */
+
+Chart :: Chart(QWidget *parent) : AstroFileHandler(parent)
+{
+    zoom = 1;
+    viewport = chartScene.defaultViewport();
+
+    view = new QGraphicsView(this);
+
+    view->setScene(chartScene.scene());
+    view->setRenderHints(QPainter::Antialiasing|QPainter::TextAntialiasing);
+    //view->installEventFilter(this);
+    view->scene()->installEventFilter(this);
+    view->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+    view->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+
+    QVBoxLayout* layout = new QVBoxLayout(this);
+    layout->setMargin(0);
+    layout->addWidget(view);
+
+    //Zodiac Server
+    if(qApp->applicationFilePath().indexOf("zodiac_server")>0){
+        view->setObjectName("chartview");
+        view->setStyleSheet("#chartview{background-color: #000}");
+    }
+}
+
+QImage Chart :: renderImage(const A::Horoscope& scope, const QSize& size, const ChartStyle& style)
+{
+    ChartScene s;
+    s.setStyle(style);
+    s.setHoroscopes(QList<A::Horoscope>() << scope);
+    s.build();
+    return s.render(size);
+}
+
+QList<A::Horoscope> Chart :: horoscopes()
+{
+    QList<A::Horoscope> ret;
+    for (int i = 0; i < filesCount(); i++)
+        ret << file(i)->horoscope();
+    return ret;
+}
+
+void Chart :: fitInView()
+{
+    //QRect rect(chartRect.x() / zoom, chartRect.y() / zoom, chartRect.width() / zoom, chartRect.height() / zoom);
+    view->fitInView(viewport, Qt::KeepAspectRatio);
+}
+
+void Chart :: createScene()
+{
+    chartScene.createScene();
+    chartScene.circleItem()->setCursor(QPixmap("chart/rotate.png"));
+
+    /*if (viewport.center() != QPointF(0,0)) */fitInView();
+}
+
+void Chart :: updateScene()
+{
+    chartScene.circleItem()->setFile(file());
+    chartScene.updateScene();
+}
+
 void Chart :: refreshAll()
 {
-    if (!chartsCount) return;
-    clearScene();
-    createScene();
+    if (!chartScene.count()) return;
+    chartScene.setZoom(zoom);
+    chartScene.setHoroscopes(horoscopes());
+    if (chartScene.isOutdated())
+    {
+        chartScene.clearScene();
+        createScene();
+    }
     updateScene();
 
     for (int i = 0; i < filesCount(); i++)
-        updatePlanetsAndCusps(i);
+        chartScene.updatePlanetsAndCusps(i);
 
-    updateAspects();
+    chartScene.updateAspects();
 }
 
 void Chart :: filesUpdated(MembersList m)
 {
-    if (chartsCount && (chartsCount != filesCount() ||     // clear if charts count or zodiac has changed
-                        (filesCount() && m[0] & AstroFile::Zodiac)))
-        clearScene();
+    int chartsCount = chartScene.count();
+    chartScene.setHoroscopes(horoscopes());
+
+    if (chartsCount && chartScene.isOutdated())            // clear if charts count or zodiac has changed
+    {
+        chartScene.clearScene();
+        chartsCount = 0;
+    }
 
     bool justCreated = false;
     bool updAspects = false;
@@ -634,7 +1152,7 @@ void Chart :: filesUpdated(MembersList m)
                          m[0] & updateFlags))
     {
         updateScene();
-        updatePlanetsAndCusps(0);
+        chartScene.updatePlanetsAndCusps(0);
         updAspects = true;
     }
 
@@ -642,12 +1160,12 @@ void Chart :: filesUpdated(MembersList m)
                              (m[1] & updateFlags) ||
                              (m[0] & updateFlags && startPoint() == Start_Ascendent)))
     {
-        updatePlanetsAndCusps(1);
+        chartScene.updatePlanetsAndCusps(1);
         updAspects = true;
     }
 
     if (updAspects)
-        updateAspects();
+        chartScene.updateAspects();
 }
 
 bool Chart :: eventFilter(QObject* obj, QEvent* ev)
@@ -688,40 +1206,35 @@ void Chart :: resizeEvent (QResizeEvent*)
 
 AppSettings Chart :: defaultSettings ()
 {
+    ChartStyle d;
     AppSettings s;
-    s.setValue ( "Circle/circleStart",      Start_Ascendent );
-    s.setValue ( "Circle/clockwise",        false );
-    s.setValue ( "Circle/zodiacWidth",      36 );
-    s.setValue ( "Circle/cuspideLength",    36 );
-    s.setValue ( "Circle/innerRadius",      130 );
-    s.setValue ( "Circle/coloredZodiac",    true );
-    s.setValue ( "Circle/zodiacDropShadow", true );
+    s.setValue ( "Circle/circleStart",      d.circleStart );
+    s.setValue ( "Circle/clockwise",        d.clockwise );
+    s.setValue ( "Circle/zodiacWidth",      d.zodiacWidth );
+    s.setValue ( "Circle/cuspideLength",    d.cuspideLength );
+    s.setValue ( "Circle/innerRadius",      d.innerRadius );
+    s.setValue ( "Circle/coloredZodiac",    d.coloredZodiac );
+    s.setValue ( "Circle/zodiacDropShadow", d.zodiacDropShadow );
     return s;
 }
 
 AppSettings Chart :: currentSettings ()
 {
+    const ChartStyle& st = chartScene.style();
     AppSettings s;
-    s.setValue ( "Circle/circleStart",      circleStart );
-    s.setValue ( "Circle/clockwise",        clockwise );
-    s.setValue ( "Circle/zodiacWidth",      l_zodiacWidth );
-    s.setValue ( "Circle/cuspideLength",    l_cuspideLength );
-    s.setValue ( "Circle/innerRadius",      l_innerRadius );
-    s.setValue ( "Circle/coloredZodiac",    coloredZodiac );
-    s.setValue ( "Circle/zodiacDropShadow", zodiacDropShadow );
+    s.setValue ( "Circle/circleStart",      st.circleStart );
+    s.setValue ( "Circle/clockwise",        st.clockwise );
+    s.setValue ( "Circle/zodiacWidth",      st.zodiacWidth );
+    s.setValue ( "Circle/cuspideLength",    st.cuspideLength );
+    s.setValue ( "Circle/innerRadius",      st.innerRadius );
+    s.setValue ( "Circle/coloredZodiac",    st.coloredZodiac );
+    s.setValue ( "Circle/zodiacDropShadow", st.zodiacDropShadow );
     return s;
 }
 
 void Chart :: applySettings       ( const AppSettings& s )
 {
-    circleStart      = (CircleStart)s.value("Circle/circleStart").toInt();
-    clockwise        = s.value ( "Circle/clockwise"        ).toBool();
-    l_zodiacWidth    = s.value ( "Circle/zodiacWidth"      ).toInt();
-    l_cuspideLength  = s.value ( "Circle/cuspideLength"    ).toInt();
-    l_innerRadius    = s.value ( "Circle/innerRadius"      ).toInt();
-    coloredZodiac    = s.value ( "Circle/coloredZodiac"    ).toBool();
-    zodiacDropShadow = s.value ( "Circle/zodiacDropShadow" ).toBool();
-
+    chartScene.setStyle(ChartStyle(s));
     refreshAll();
 }
 
@@ -3,6 +3,7 @@
 
 #include <QGraphicsItem>
 #include <QGraphicsScene>
+#include <QImage>
 #include <Astroprocessor/Gui>
 
 enum CircleStart { Start_ZeroDegree = 0, Start_Ascendent = 1 };
@@ -10,10 +11,63 @@ enum CircleStart { Start_ZeroDegree = 0, Start_Ascendent = 1 };
 class Chart;
 
 
+struct ChartStyle                             // the "Circle/..." settings of the chart
+{
+    CircleStart circleStart;
+    bool clockwise;
+    int zodiacWidth;
+    int cuspideLength;
+    int innerRadius;
+    bool coloredZodiac;
+    bool zodiacDropShadow;
+    QColor background;                        // of rendered images
+
+    ChartStyle();                             // default settings
+    ChartStyle(const AppSettings& s);         // missing values are default
+    bool operator==(const ChartStyle& other) const;
+};
+
+
+/* =========================== ZODIAC RING ========================================== */
+
+// Colored band of the zodiac with its borders, sign borders and drop shadow.
+// It doesn't depend on a chart, so it is drawn once per zodiac, style and device
+// size into an image which is shared by all scenes (on all threads). A ring too
+// big for that which is only partly on the device (a tile) is drawn piece by piece.
+// Vector devices (SVG, PDF) get the band as paths, without the shadow.
+
+class ZodiacRing
+{
+    private:
+        A::Zodiac zodiac;
+        QRectF rect;                          // outer circle, in scene coordinates
+        float width;                          // of the band
+        bool colored;
+        bool dropShadow;
+        bool clockwise;
+
+        static const int cachedPixels = 4 * 1024 * 1024;   // bigger rings are drawn by the visible piece
+
+        void addBand(QGraphicsScene& s, const QTransform& transform = QTransform());
+        QImage draw(const QSize& size);
+        QImage draw(const QRect& piece, const QTransform& transform, qreal ratio);   // piece of the device
+
+    public:
+        ZodiacRing(const A::Zodiac& zodiac, const QRectF& rect, float width, const ChartStyle& style);
+
+        const QRectF& circleRect() const      { return rect; }
+        float bandWidth() const               { return width; }
+        QRectF bounds() const;                // including the shadow
+        QImage image(const QSize& size);      // bounds() drawn into given size, cached
+        void paint(QPainter* p);              // cached image in resolution of the device
+        void drawBand(QPainter* p, bool vector);   // without the shadow
+};
+
+
 class RotatingCircleItem : public QAbstractGraphicsShapeItem
 {
     private:
-        QRectF rect;
+        ZodiacRing ring;
         float dragAngle;
         QDateTime dragDT;
         AstroFile* file;
@@ -27,52 +81,54 @@ class RotatingCircleItem : public QAbstractGraphicsShapeItem
         bool sceneEvent(QEvent *event);
 
     public:
-        RotatingCircleItem(QRect rect, const QPen& pen);
+        RotatingCircleItem(const ZodiacRing& ring);
         QPainterPath shape() const;
-        QRectF boundingRect() const { return rect; }
+        QRectF boundingRect() const { return ring.bounds(); }
 
         void setFile(AstroFile* f) { file = f; }
         void setHelpTag(QGraphicsItem* item, QString tag);
 };
 
 
-/* =========================== ASTRO MAP SHOW ======================================= */
+/* =========================== CHART SCENE ========================================== */
 
-class Chart : public AstroFileHandler
-{
-    Q_OBJECT
+// Graphics scene of one chart or a synastry of two, without a view or a widget.
+// It can be built and rendered on any thread (offscreen QPA platform will do).
+// Items are created once for a layout (charts count, zodiac, planets, style and
+// zoom); the following charts with the same layout only move them.
+// saveTiled() renders a png by bands of rows on several threads, each with its own
+// scene, and streams them to the file in order. Each band draws its own piece of
+// the zodiac ring, so memory is bounded by a few bands.
 
+class ChartScene
+{
     private:
         typedef QMap<A::PlanetId, QGraphicsItem*> QGraphicsItemDict;
 
-        static const int defaultChartRadius = 250;
-        int chartsCount;
-        QRectF viewport;
+        QGraphicsScene* s;
+        QList<A::Horoscope> charts;
+        ChartStyle st;
         float zoom;
-        QGraphicsView* view;
+        int chartsCount;                      // charts the scene was created for
         RotatingCircleItem* circle;
-        //A::AspectList synAspects;
 
-        CircleStart circleStart;
-        bool clockwise;
-        int l_zodiacWidth;
-        int l_innerRadius;
-        int l_cuspideLength;
-        bool coloredZodiac;
-        bool zodiacDropShadow;
+        ChartStyle builtStyle;                // layout the items were created for
+        float builtZoom;
+        A::ZodiacId builtZodiac;
+        QList< QList<A::PlanetId> > builtPlanets;
 
         QMap<int, QGraphicsItemDict> cuspides;
         QMap<int, QGraphicsItemDict> cuspideLabels;
         QMap<int, QGraphicsItemDict> planetMarkers;
         QMap<int, QGraphicsItemDict> planets;
         //QList<QGraphicsSimpleTextItem*> aspectMarkers;
-        QList<QGraphicsLineItem*>         aspects;
+        QList<QGraphicsLineItem*>         aspects;          // the ones after aspectsCount are hidden
+        int                               aspectsCount;
         QList<QGraphicsItem*>             signIcons;
 
-        float zodiacWidth()  { return l_zodiacWidth * zoom; }
+        float zodiacWidth()  { return st.zodiacWidth * zoom; }
         float innerRadius(int fileIndex = 0);
         int cuspideLength(int fileIndex, int cusp);
-        QRect chartRect();
 
         int normalPlanetPosX(QGraphicsItem* planet, QGraphicsItem* marker);
         const QPen& aspectPen(const A::Aspect& asp);
@@ -81,15 +137,65 @@ class Chart : public AstroFileHandler
         QColor planetShapeColor(const A::Planet& p, int fileIndex);
         QGraphicsItem* getCircleMarker(const A::Planet* p);
 
+        QGraphicsSimpleTextItem* addText(const QString& text, const QFont& font);   // as outlines on vector devices
         void drawPlanets(int fileIndex);
         void drawCuspides(int fileIndex);
+
+        ChartScene(const ChartScene&);
+        ChartScene& operator=(const ChartScene&);
+
+    public:
+        static const int defaultChartRadius = 250;
+        static const int tiledPixels = 4 * 1024 * 1024;   // bigger png images are saved by saveTiled()
+
+        ChartScene();
+        ~ChartScene();
+
+        QGraphicsScene* scene()               { return s; }
+        RotatingCircleItem* circleItem()      { return circle; }
+        int count()                           { return chartsCount; }     // 0 if the scene is empty
+        QRect chartRect();
+        QRectF defaultViewport();             // the chart with a margin
+
+        const ChartStyle& style()             { return st; }
+        void setStyle(const ChartStyle& style) { st = style; }           // takes effect on createScene()
+        void setZoom(float z)                 { zoom = z; }              // same
+        void setHoroscopes(const QList<A::Horoscope>& list) { charts = list; }
+        bool isOutdated();                    // charts need another layout than the created one
+
+        void createScene();
+        void updateScene();
         void updatePlanetsAndCusps(int fileIndex);
         void updateAspects();
+        void clearScene();
+        void build();                         // creates the scene if outdated and updates everything
+
+        void render(QPainter* p, const QRectF& target, QRectF viewport = QRectF());   // default viewport if null
+        QImage render(const QSize& size, QRectF viewport = QRectF());
+        bool save(const QString& fileName, const QSize& size,      // format: "svg", "pdf" or of QImageWriter,
+                  QByteArray format = QByteArray(),                // by the suffix of fileName if empty;
+                  int compression = -1);                           // png: zlib level 0...9
+        bool saveTiled(const QString& fileName, const QSize& size, int compression = -1);
+};
+
+
+/* =========================== ASTRO MAP SHOW ======================================= */
+
+class Chart : public AstroFileHandler
+{
+    Q_OBJECT
+
+    private:
+        ChartScene chartScene;
+        QRectF viewport;
+        float zoom;
+        QGraphicsView* view;
+
+        QList<A::Horoscope> horoscopes();
 
         void fitInView();
         void createScene();
         void updateScene();
-        void clearScene();
 
         void refreshAll();
 
@@ -111,8 +217,12 @@ class Chart : public AstroFileHandler
         Chart(QWidget *parent = 0);
 
         void help(QString tag)    { requestHelp(tag); }    // called by circle item (because requestHelp() is protected)
-        bool isClockwise()        { return clockwise; }
-        CircleStart startPoint()  { return circleStart; }
+        bool isClockwise()        { return chartScene.style().clockwise; }
+        CircleStart startPoint()  { return chartScene.style().circleStart; }
+
+        // Renders the chart into an image of given size, without a widget and
+        // an event loop; callable from any thread.
+        static QImage renderImage(const A::Horoscope& scope, const QSize& size, const ChartStyle& style = ChartStyle());
 };
 
 #endif // CHART_H
@@ -0,0 +1,111 @@
+#include <QtEndian>
+#include "pngwriter.h"
+
+#ifdef Q_OS_WIN
+#include <QtZlib/zlib.h>
+#else
+#include <zlib.h>
+#endif
+
+
+/* =========================== PNG WRITER =========================================== */
+
+static QByteArray bigEndian(quint32 value)
+{
+    QByteArray ret(4, 0);
+    qToBigEndian(value, (uchar*)ret.data());
+    return ret;
+}
+
+PngWriter :: PngWriter(const QString& fileName) : file(fileName)
+{
+    adler = 1;
+}
+
+bool PngWriter :: writeChunk(const char* type, const QByteArray& data)
+{
+    uLong crc = crc32(0, (const Bytef*)type, 4);
+    crc = crc32(crc, (const Bytef*)data.constData(), data.size());
+
+    return file.write(bigEndian(data.size())) == 4 &&
+           file.write(type, 4) == 4 &&
+           file.write(data) == data.size() &&
+           file.write(bigEndian(crc)) == 4;
+}
+
+bool PngWriter :: begin(const QSize& size, bool alpha)
+{
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    adler = 1;
+
+    QByteArray header = bigEndian(size.width()) + bigEndian(size.height());
+    header += char(8);                        // bits per channel
+    header += char(alpha ? 6 : 2);            // color type
+    header += QByteArray(3, 0);               // compression, filter and interlace methods
+
+    return file.write("\x89PNG\r\n\x1a\n", 8) == 8 &&
+           writeChunk("IHDR", header) &&
+           writeChunk("IDAT", QByteArray("\x78\x9c", 2));    // zlib header, the bands follow
+}
+
+bool PngWriter :: write(const Band& band)
+{
+    adler = adler32_combine(adler, band.adler, band.length);
+    return writeChunk("IDAT", band.data);
+}
+
+bool PngWriter :: end()
+{
+    QByteArray data("\x03\x00", 2);           // final empty block
+    data += bigEndian(adler);
+
+    bool ok = writeChunk("IDAT", data) && writeChunk("IEND", QByteArray());
+    file.close();
+    return ok;
+}
+
+PngWriter::Band PngWriter :: compress(const QImage& rows, int level)
+{
+    int bpp = (rows.format() == QImage::Format_RGBA8888 ? 4 : 3);
+    int rowLength = rows.width() * bpp;
+    QByteArray filtered(rows.height() * (rowLength + 1), 0);
+    uchar* out = (uchar*)filtered.data();
+
+    for (int y = 0; y < rows.height(); y++)   // "Sub" filter: no dependency on the row above, which may be in another band
+    {
+        const uchar* in = rows.constScanLine(y);
+        *out++ = 1;
+        for (int x = 0; x < bpp; x++)
+            *out++ = in[x];
+        for (int x = bpp; x < rowLength; x++)
+            *out++ = in[x] - in[x - bpp];
+    }
+
+    Band ret;
+    ret.length = filtered.size();
+    ret.adler  = adler32(adler32(0, 0, 0), (const Bytef*)filtered.constData(), filtered.size());
+
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    deflateInit2(&z, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);   // raw deflate, the writer has the zlib header
+    ret.data.resize(deflateBound(&z, filtered.size()) + 16);
+    z.next_in   = (Bytef*)filtered.data();
+    z.avail_in  = filtered.size();
+    z.next_out  = (Bytef*)ret.data.data();
+    z.avail_out = ret.data.size();
+
+    while (true)                              // full flush: ends on a byte boundary and the next band
+    {                                         // doesn't refer to this one
+        deflate(&z, Z_FULL_FLUSH);
+        if (z.avail_out) break;
+
+        int done = ret.data.size();
+        ret.data.resize(done * 2);
+        z.next_out  = (Bytef*)ret.data.data() + done;
+        z.avail_out = ret.data.size() - done;
+    }
+
+    ret.data.resize(ret.data.size() - z.avail_out);
+    deflateEnd(&z);
+    return ret;
+}
@@ -0,0 +1,39 @@
+#ifndef PNGWRITER_H
+#define PNGWRITER_H
+
+#include <QFile>
+#include <QImage>
+
+
+/* =========================== PNG WRITER =========================================== */
+
+// PNG file written band by band, from the top. Bands are filtered and deflated
+// independently by compress(), which is thread safe, and joined into one zlib
+// stream: they can be encoded in parallel and the image is never whole in memory.
+
+class PngWriter
+{
+    public:
+        struct Band                           // deflated rows of the image
+        {
+            QByteArray data;
+            quint32 adler;                    // checksum of the filtered rows
+            qint64 length;                    // and their size
+        };
+
+        PngWriter(const QString& fileName);
+
+        bool begin(const QSize& size, bool alpha);    // RGBA if alpha, RGB otherwise
+        bool write(const Band& band);
+        bool end();
+
+        static Band compress(const QImage& rows, int level);   // rows: Format_RGB888 or Format_RGBA8888; level: zlib 0...9 or -1
+
+    private:
+        QFile file;
+        quint32 adler;
+
+        bool writeChunk(const char* type, const QByteArray& data);
+};
+
+#endif // PNGWRITER_H
@@ -3,6 +3,7 @@ swedate.c \
 swehouse.c \
 swejpl.c \
 swemmoon.c \
+swemmap.c \
 swemplan.c \
 swemptab.c \
 swepcalc.c \
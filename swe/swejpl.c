@@ -79,7 +79,7 @@ struct jpl_save {
   short do_km;
 };
 
-static struct jpl_save *FAR js;
+static TLS struct jpl_save *FAR js;
 
 static int state (double et, int32 *list, int do_bary, 
 		  double *pv, double *pvsun, double *nut, char *serr);
@@ -405,10 +405,10 @@ static int interp(double FAR *buf, double t, double intv, int32 ncfin,
 		  int32 ncmin, int32 nain, int32 ifl, double *pv)
 {
   /* Initialized data */
-  static int FAR np, nv;
-  static int FAR nac;
-  static int FAR njk;
-  static double FAR twot = 0.;
+  static TLS int FAR np, nv;
+  static TLS int FAR nac;
+  static TLS int FAR njk;
+  static TLS double FAR twot = 0.;
   double FAR *pc = js->pc;
   double FAR *vc = js->vc;
   double FAR *ac = js->ac;
@@ -593,8 +593,8 @@ static int state(double et, int32 *list, int do_bary,
   double et_mn, et_fr;
   int32 FAR *ipt = js->eh_ipt;
   char *ch_ttl[252];
-  static int32 irecsz;
-  static int32 nrl, lpt[3], ncoeffs;
+  static TLS int32 irecsz;
+  static TLS int32 nrl, lpt[3], ncoeffs;
   if (js->jplfptr == NULL) {
     ksize = fsizer(serr); /* the number of single precision words in a record */
     nrecl = 4;
@@ -0,0 +1,81 @@
+/*********************************************************
+  read only memory mapping of Swiss Ephemeris files
+
+  swi_map_file()	maps a whole open ephemeris file
+  swi_unmap_file()	releases the mapping
+
+  Used by sweph.c to decode segment indexes and packed
+  chebyshew coefficients directly from the file image.
+  This file does not include the swe headers, because the
+  system headers needed here (windows.h) collide with sweodef.h.
+  Compile with -DNO_MMAP to keep all ephemeris reads on stdio.
+**********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(NO_MMAP)
+/* nothing */
+#elif defined(_WIN32)
+# include <windows.h>
+# include <io.h>
+#else
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
+/* returns a pointer to the file image and its length in *len,
+ * or NULL, if the file cannot be mapped. The FILE stays open
+ * and usable; the mapping does not depend on it. */
+unsigned char *swi_map_file(FILE *fp, long *len)
+{
+#if defined(NO_MMAP)
+  *len = 0;
+  return NULL;
+#elif defined(_WIN32)
+  HANDLE hfile, hmap;
+  LARGE_INTEGER size;
+  void *p;
+  *len = 0;
+  hfile = (HANDLE) _get_osfhandle(_fileno(fp));
+  if (hfile == INVALID_HANDLE_VALUE || !GetFileSizeEx(hfile, &size))
+    return NULL;
+  if (size.QuadPart <= 0 || size.QuadPart > 0x7fffffff)
+    return NULL;
+  hmap = CreateFileMapping(hfile, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (hmap == NULL)
+    return NULL;
+  p = MapViewOfFile(hmap, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(hmap);	/* the view keeps the mapping alive */
+  if (p == NULL)
+    return NULL;
+  *len = (long) size.QuadPart;
+  return (unsigned char *) p;
+#else
+  struct stat st;
+  void *p;
+  *len = 0;
+  if (fstat(fileno(fp), &st) != 0 || st.st_size <= 0 || st.st_size > 0x7fffffff)
+    return NULL;
+  p = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0);
+  if (p == MAP_FAILED)
+    return NULL;
+  *len = (long) st.st_size;
+  return (unsigned char *) p;
+#endif
+}
+
+void swi_unmap_file(unsigned char *p, long len)
+{
+  if (p == NULL)
+    return;
+#if defined(NO_MMAP)
+  /* nothing */
+#elif defined(_WIN32)
+  UnmapViewOfFile(p);
+#else
+  munmap((void *) p, (size_t) len);
+#endif
+}
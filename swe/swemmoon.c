@@ -709,39 +709,39 @@ Multiply by T^2
  * to the same instant.  The distinction between them
  * is required by altaz().
  */
-static double FAR ss[5][8]; 
-static double FAR cc[5][8];
+static TLS double FAR ss[5][8]; 
+static TLS double FAR cc[5][8];
 
-static double l;		/* Moon's ecliptic longitude */
-static double B;		/* Ecliptic latitude */
+static TLS double l;		/* Moon's ecliptic longitude */
+static TLS double B;		/* Ecliptic latitude */
 
-static double moonpol[3];
+static TLS double moonpol[3];
 
 /* Orbit calculation begins.
  */
-static double SWELP;
-static double M;
-static double MP;
-static double D;
-static double NF;
-static double T;
-static double T2;
-
-static double T3;
-static double T4;
-static double f;
-static double g;
-static double Ve;
-static double Ea;
-static double Ma;
-static double Ju;
-static double Sa;
-static double cg;
-static double sg;
-static double l1;
-static double l2;
-static double l3;
-static double l4;
+static TLS double SWELP;
+static TLS double M;
+static TLS double MP;
+static TLS double D;
+static TLS double NF;
+static TLS double T;
+static TLS double T2;
+
+static TLS double T3;
+static TLS double T4;
+static TLS double f;
+static TLS double g;
+static TLS double Ve;
+static TLS double Ea;
+static TLS double Ma;
+static TLS double Ju;
+static TLS double Sa;
+static TLS double cg;
+static TLS double sg;
+static TLS double l1;
+static TLS double l2;
+static TLS double l3;
+static TLS double l4;
 
 /* Calculate geometric coordinates of Moon
  * without light time or nutation correction.
@@ -112,8 +112,8 @@ static struct plantbl *planets[] =
   &plu404
 };
 
-static double FAR ss[9][24];
-static double FAR cc[9][24];
+static TLS double FAR ss[9][24];
+static TLS double FAR cc[9][24];
 
 static void sscc (int k, double arg, int n);
 
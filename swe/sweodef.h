@@ -253,6 +253,21 @@ typedef unsigned char UCHAR;
  
 #define forward static
 
+/* Thread local storage for the ephemeris state (swed, cached segments,
+ * saved positions and scratch variables), so that several threads can
+ * call swe_calc() & co. at the same time. Every thread has to set its
+ * own ephemeris path and call swe_close() before it ends.
+ * Compile with -DNO_TLS for the old single threaded behaviour. */
+#ifndef TLS
+# if defined(NO_TLS)
+#  define TLS
+# elif defined(_MSC_VER)
+#  define TLS __declspec(thread)
+# else
+#  define TLS __thread
+# endif
+#endif
+
 #define AS_MAXCH 256    /* used for string declarations, allowing 255 char+\0 */
  
 #define DEGTORAD 0.0174532925199433
@@ -69,7 +69,7 @@ struct meff_ele {double r,m;};
 /****************
  * global stuff *
  ****************/
-struct swe_data FAR swed = {FALSE,	/* ephe_path_is_set = FALSE */
+TLS struct swe_data FAR swed = {FALSE,	/* ephe_path_is_set = FALSE */
                             FALSE,	/* jpl_file_is_open = FALSE */
                             NULL,	/* fixed stars file pointer */
 			    SE_EPHE_PATH,		/* ephe path */
@@ -113,6 +113,14 @@ static int do_fread(void *targ, int size, int count, int corrsize,
 		    FILE *fp, int32 fpos, int freord, int fendian, int ifno, 
 		    char *serr);
 static int get_new_segment(double tjd, int ipli, int ifno, char *serr);
+static int get_new_segment_mapped(double tjd, int ipli, int ifno, char *serr);
+static int load_fixstars(char *serr);
+static int32 fixstar_search(char *sstar, size_t cmplen, AS_BOOL isnomclat);
+static void free_fixstars(void);
+static AS_BOOL seg_cache_get(double tjd, int ipli);
+static void seg_cache_put(int ipli);
+static void seg_cache_free(struct plan_data *pdp);
+static uint32 map_uint(unsigned char *p, int size, int litend);
 static int main_planet(double tjd, int ipli, int32 epheflag, int32 iflag,
 		       char *serr);
 static int main_planet_bary(double tjd, int ipli, int32 epheflag, int32 iflag, 
@@ -176,7 +184,7 @@ int32 FAR PASCAL_CONV swe_calc(double tjd, int ipl, int32 iflag,
   int32 iflgcoor;
   int32 iflgsave = iflag;
   int32 epheflag;
-  static int32 epheflag_sv = 0;
+  static TLS int32 epheflag_sv = 0;
   struct save_positions *sd;
   double x[6], *xs, x0[24], x2[24];
   double dt;
@@ -196,9 +204,9 @@ int32 FAR PASCAL_CONV swe_calc(double tjd, int ipl, int32 iflag,
    * FORCE_IFLAG and then running the application with this DLL (we had no
    * source code of the application itself).
    */
-  static int force_flag = 0;
-  static int32 iflag_forced = 0;
-  static int force_flag_checked = 0;
+  static TLS int force_flag = 0;
+  static TLS int32 iflag_forced = 0;
+  static TLS int force_flag_checked = 0;
   FILE *fp;
   char s[AS_MAXCH], *sp;
   memset(x, 0, sizeof(double) * 6);
@@ -982,10 +990,12 @@ void FAR PASCAL_CONV swe_close(void)
   for (i = 0; i < SEI_NEPHFILES; i ++) {
     if (swed.fidat[i].fptr != NULL) 
       fclose(swed.fidat[i].fptr);
+    swi_unmap_file(swed.fidat[i].fmap, swed.fidat[i].fmaplen);
     memset((void *) &swed.fidat[i], 0, sizeof(struct file_data));
   }
   /* free planets data space */
   for (i = 0; i < SEI_NPLANETS; i++) {
+    seg_cache_free(&swed.pldat[i]);
     if (swed.pldat[i].segp != NULL) {
       free((void *) swed.pldat[i].segp);
     }
@@ -1019,6 +1029,11 @@ void FAR PASCAL_CONV swe_close(void)
     fclose(swed.fixfp);
     swed.fixfp = NULL;
   }
+  free_fixstars();
+  if (swed.nut2000a != NULL) {
+    free((void *) swed.nut2000a);
+    swed.nut2000a = NULL;
+  }
 #ifdef TRACE
 #define TRACE_CLOSE FALSE
   swi_open_trace(NULL);
@@ -1148,7 +1163,14 @@ void FAR PASCAL_CONV swe_set_jpl_file(char *fname)
  */
 static void calc_epsilon(double tjd, struct epsilon *e)
 {
+    double v[3];
     e->teps = tjd;
+    if (swi_nuttab_epsilon(tjd, v)) {
+      e->eps = v[0];
+      e->seps = v[1];
+      e->ceps = v[2];
+      return;
+    }
     e->eps = swi_epsiln(tjd);
     e->seps = sin(e->eps);
     e->ceps = cos(e->eps);
@@ -1786,6 +1808,10 @@ static int sweph(double tjd, int ipli, int ifno, int32 iflag, double *xsunb, AS_
       || (ipl == SEI_ANYBODY && ipli != pdp->ibdy)) { 	
       fclose(fdp->fptr);
       fdp->fptr = NULL;
+      swi_unmap_file(fdp->fmap, fdp->fmaplen);
+      fdp->fmap = NULL;
+      fdp->fmaplen = 0;
+      seg_cache_free(pdp);
       if (pdp->refep != NULL)
 	free((void *) pdp->refep);
       pdp->refep = NULL;
@@ -1840,6 +1866,8 @@ again:
     retc = read_const(ifno, serr);
     if (retc != OK)
       return(retc);
+    /* segments are decoded from a memory image of the file, if possible */
+    fdp->fmap = swi_map_file(fdp->fptr, &fdp->fmaplen);
   }
   /* if first ephemeris file (J-3000), it might start a mars period
    * after -3000. if last ephemeris file (J3000), it might end a
@@ -1861,7 +1889,8 @@ again:
    * get planet's position      
    ******************************/
   /* get new segment, if necessary */
-  if (pdp->segp == NULL || tjd < pdp->tseg0 || tjd > pdp->tseg1) {
+  if ((pdp->segp == NULL || tjd < pdp->tseg0 || tjd > pdp->tseg1)
+      && !seg_cache_get(tjd, ipl)) {
     retc = get_new_segment(tjd, ipl, ifno, serr);
     if (retc != OK)
       return(retc);
@@ -1871,6 +1900,7 @@ again:
       rot_back(ipl); /**/
     else
       pdp->neval = pdp->ncoe;
+    seg_cache_put(ipl);
   }
   /* evaluate chebyshew polynomial for tjd */
   t = (tjd - pdp->tseg0) / pdp->dseg;
@@ -3482,6 +3512,8 @@ static int get_new_segment(double tjd, int ipli, int ifno, char *serr)
   int freord  = (int) fdp->iflg & SEI_FILE_REORD;
   int fendian = (int) fdp->iflg & SEI_FILE_LITENDIAN;
   uint32 longs[MAXORD+1];
+  if (fdp->fmap != NULL)
+    return get_new_segment_mapped(tjd, ipli, ifno, serr);
   /* compute segment number */
   iseg = (int32) ((tjd - pdp->tfstart) / pdp->dseg);
   /*if (tjd - pdp->tfstart < 0)
@@ -3603,6 +3635,266 @@ static int get_new_segment(double tjd, int ipli, int ifno, char *serr)
   return(OK);
 }
 
+/* sets the number of decoded segments that are kept per body.
+ * segments are stored after rot_back(), so a cache hit costs only
+ * a copy of 3 x ncoe doubles, no file access and no unpacking.
+ * nseg <= 0 switches the cache off. the setting is per thread,
+ * like all ephemeris data.
+ */
+void FAR PASCAL_CONV swe_set_segment_cache(int32 nseg)
+{
+  int i;
+  for (i = 0; i < SEI_NPLANETS; i++)
+    seg_cache_free(&swed.pldat[i]);
+  if (nseg <= 0)
+    swed.segc_size = -1;
+  else if (nseg > SEI_SEGC_MAX)
+    swed.segc_size = SEI_SEGC_MAX;
+  else
+    swed.segc_size = nseg;
+}
+
+void FAR PASCAL_CONV swe_get_segment_cache_stats(int32 *hits, int32 *misses, int32 reset)
+{
+  if (hits != NULL)
+    *hits = swed.segc_hits;
+  if (misses != NULL)
+    *misses = swed.segc_misses;
+  if (reset) {
+    swed.segc_hits = 0;
+    swed.segc_misses = 0;
+  }
+}
+
+/* looks for a cached segment of body ipli containing tjd and
+ * makes it the current segment */
+static AS_BOOL seg_cache_get(double tjd, int ipli)
+{
+  int i;
+  struct plan_data *pdp = &swed.pldat[ipli];
+  struct seg_cache *sc;
+  if (swed.segc_size < 0)
+    return FALSE;
+  for (i = 0, sc = pdp->segc; i < pdp->nsegc; i++, sc++) {
+    if (sc->segp != NULL && tjd >= sc->tseg0 && tjd <= sc->tseg1) {
+      if (pdp->segp == NULL)
+	pdp->segp = (double *) malloc((size_t) pdp->ncoe * 3 * 8);
+      if (pdp->segp == NULL)
+	return FALSE;
+      memcpy((void *) pdp->segp, (void *) sc->segp, (size_t) pdp->ncoe * 3 * 8);
+      pdp->tseg0 = sc->tseg0;
+      pdp->tseg1 = sc->tseg1;
+      pdp->neval = sc->neval;
+      sc->used = ++pdp->segc_clock;
+      swed.segc_hits++;
+      return TRUE;
+    }
+  }
+  swed.segc_misses++;
+  return FALSE;
+}
+
+/* stores the current segment of body ipli, replacing the least 
+ * recently used one */
+static void seg_cache_put(int ipli)
+{
+  int i;
+  struct plan_data *pdp = &swed.pldat[ipli];
+  struct seg_cache *sc, *slot;
+  if (swed.segc_size < 0)
+    return;
+  if (pdp->segc == NULL) {
+    pdp->nsegc = swed.segc_size > 0 ? swed.segc_size : SEI_SEGC_DEFAULT;
+    pdp->segc = (struct seg_cache *) calloc((size_t) pdp->nsegc, sizeof(struct seg_cache));
+    if (pdp->segc == NULL) {
+      pdp->nsegc = 0;
+      return;
+    }
+  }
+  slot = pdp->segc;
+  for (i = 0, sc = pdp->segc; i < pdp->nsegc; i++, sc++) {
+    if (sc->segp == NULL) {
+      slot = sc;
+      break;
+    }
+    if (sc->used < slot->used)
+      slot = sc;
+  }
+  if (slot->segp == NULL)
+    slot->segp = (double *) malloc((size_t) pdp->ncoe * 3 * 8);
+  if (slot->segp == NULL)
+    return;
+  memcpy((void *) slot->segp, (void *) pdp->segp, (size_t) pdp->ncoe * 3 * 8);
+  slot->tseg0 = pdp->tseg0;
+  slot->tseg1 = pdp->tseg1;
+  slot->neval = pdp->neval;
+  slot->used = ++pdp->segc_clock;
+}
+
+static void seg_cache_free(struct plan_data *pdp)
+{
+  int i;
+  if (pdp->segc == NULL)
+    return;
+  for (i = 0; i < pdp->nsegc; i++)
+    if (pdp->segc[i].segp != NULL)
+      free((void *) pdp->segc[i].segp);
+  free((void *) pdp->segc);
+  pdp->segc = NULL;
+  pdp->nsegc = 0;
+}
+
+/* reads an unsigned integer of 'size' bytes (1...4), stored 
+ * in the byte order of the ephemeris file */
+static uint32 map_uint(unsigned char *p, int size, int litend)
+{
+  uint32 u = 0;
+  int i;
+  if (litend)
+    for (i = size - 1; i >= 0; i--)
+      u = (u << 8) | p[i];
+  else
+    for (i = 0; i < size; i++)
+      u = (u << 8) | p[i];
+  return u;
+}
+
+/* same as get_new_segment(), for a memory mapped ephemeris file:
+ * the segment index and the packed coefficients are decoded directly 
+ * from the file image, without fseek()/fread() and byte reordering 
+ * through a buffer. Results are identical to the stdio path.
+ */
+static int get_new_segment_mapped(double tjd, int ipli, int ifno, char *serr) 
+{
+  int i, j, k, m, n, o, icoord;
+  int32 iseg;
+  int32 fpos;
+  int nsizes, nsize[6];
+  int nco;
+  int idbl;
+  uint32 u;
+  unsigned char c[4];
+  unsigned char *p;
+  struct plan_data *pdp = &swed.pldat[ipli];
+  struct file_data *fdp = &swed.fidat[ifno];
+  unsigned char *pend = fdp->fmap + fdp->fmaplen;
+  int litend = (int) fdp->iflg & SEI_FILE_LITENDIAN;
+  /* compute segment number */
+  iseg = (int32) ((tjd - pdp->tfstart) / pdp->dseg);
+  pdp->tseg0 = pdp->tfstart + iseg * pdp->dseg;
+  pdp->tseg1 = pdp->tseg0 + pdp->dseg;
+  /* get file position of coefficients from the segment index */
+  fpos = pdp->lndx0 + iseg * 3;
+  if (fpos < 0 || fpos + 3 > fdp->fmaplen)
+    goto file_damage;
+  fpos = (int32) map_uint(fdp->fmap + fpos, 3, litend);
+  if (fpos < 0 || fpos >= fdp->fmaplen)
+    goto file_damage;
+  p = fdp->fmap + fpos;
+  /* clear space of chebyshew coefficients */
+  if (pdp->segp == NULL)
+    pdp->segp = (double *) malloc((size_t) pdp->ncoe * 3 * 8);
+  memset((void *) pdp->segp, 0, (size_t) pdp->ncoe * 3 * 8);
+  /* decode coefficients for 3 coordinates */
+  for (icoord = 0; icoord < 3; icoord++) {
+    idbl = icoord * pdp->ncoe;
+    /* header: first bit indicates number of sizes of packed coefficients */
+    if (p + 2 > pend)
+      goto file_damage;
+    c[0] = *p++;
+    c[1] = *p++;
+    if (c[0] & 128) {
+      nsizes = 6;
+      if (p + 2 > pend)
+	goto file_damage;
+      c[2] = *p++;
+      c[3] = *p++;
+      nsize[0] = (int) c[1] / 16;
+      nsize[1] = (int) c[1] % 16;
+      nsize[2] = (int) c[2] / 16;
+      nsize[3] = (int) c[2] % 16;
+      nsize[4] = (int) c[3] / 16;
+      nsize[5] = (int) c[3] % 16;
+      nco = nsize[0] + nsize[1] + nsize[2] + nsize[3] + nsize[4] + nsize[5];
+    } else {
+      nsizes = 4;
+      nsize[0] = (int) c[0] / 16;
+      nsize[1] = (int) c[0] % 16;
+      nsize[2] = (int) c[1] / 16;
+      nsize[3] = (int) c[1] % 16;
+      nco = nsize[0] + nsize[1] + nsize[2] + nsize[3];
+    }
+    /* there may not be more coefficients than interpolation
+     * order + 1 */
+    if (nco > pdp->ncoe) {
+      if (serr != NULL) {
+	sprintf(serr, "error in ephemeris file: %d coefficients instead of %d. ", nco, pdp->ncoe);
+	if (strlen(serr) + strlen(fdp->fnam) < AS_MAXCH - 1)
+	  sprintf(serr, "error in ephemeris file %s: %d coefficients instead of %d. ", fdp->fnam, nco, pdp->ncoe);
+      }
+      return (ERR);
+    }
+    /* now unpack; the arithmetic is the same as in get_new_segment() */
+    for (i = 0; i < nsizes; i++) {
+      if (nsize[i] == 0) 
+	continue;
+      if (i < 4) {
+	j = (4 - i);
+	k = nsize[i];
+	if (p + j * k > pend)
+	  goto file_damage;
+	for (m = 0; m < k; m++, idbl++, p += j) {
+	  u = map_uint(p, j, litend);
+	  if (u & 1) 	/* will be negative */
+	    pdp->segp[idbl] = -(((u+1) / 2) / 1e+9 * pdp->rmax / 2); 
+	  else
+	    pdp->segp[idbl] = (u / 2) / 1e+9 * pdp->rmax / 2;
+	}
+      } else if (i == 4) {		/* half byte packing */
+	k = (nsize[i] + 1) / 2;
+	if (p + k > pend)
+	  goto file_damage;
+	for (m = 0, j = 0; m < k && j < nsize[i]; m++) {
+	  u = p[m];
+	  for (n = 0, o = 16; 
+	       n < 2 && j < nsize[i]; 
+	       n++, j++, idbl++, u %= o, o /= 16) {
+	    if (u & o) 
+	      pdp->segp[idbl] = -(((u+o) / o / 2) * pdp->rmax / 2 / 1e+9);
+	    else
+	      pdp->segp[idbl] = (u / o / 2) * pdp->rmax / 2 / 1e+9;
+	  } 
+	}
+	p += k;
+      } else if (i == 5) {		/* quarter byte packing */
+	k = (nsize[i] + 3) / 4;
+	if (p + k > pend)
+	  goto file_damage;
+	for (m = 0, j = 0; m < k && j < nsize[i]; m++) {
+	  u = p[m];
+	  for (n = 0, o = 64; 
+	       n < 4 && j < nsize[i]; 
+	       n++, j++, idbl++, u %= o, o /= 4) {
+	    if (u & o) 
+	      pdp->segp[idbl] = -(((u+o) / o / 2) * pdp->rmax / 2 / 1e+9);
+	    else
+	      pdp->segp[idbl] = (u / o / 2) * pdp->rmax / 2 / 1e+9;
+	  } 
+	}
+	p += k;
+      }
+    }
+  }
+  return(OK);
+file_damage:
+  if (serr != NULL) {
+    strcpy(serr, "Ephemeris file is damaged. ");
+    if (strlen(serr) + strlen(fdp->fnam) < AS_MAXCH - 1)
+      sprintf(serr, "Ephemeris file %s is damaged.", fdp->fnam);
+  }
+  return(ERR);
+}
+
 /* SWISSEPH
  * reads constants on ephemeris file
  * ifno         file #
@@ -3887,6 +4179,8 @@ fendian, ifno, serr);
     else
       pdp = &swed.pldat[ipli];
     pdp->ibdy = ipli;
+    /* decoded segments of the previous file are of no use any more */
+    seg_cache_free(pdp);
     /* file position of planet's index */
     retc = do_fread((void *) &pdp->lndx0, 4, 1, 4, fp, SEI_CURR_FPOS,
 freord, fendian, ifno, serr);
@@ -5095,7 +5389,7 @@ void swi_check_ecliptic(double tjd)
 void swi_check_nutation(double tjd, int32 iflag)
 {
   int32 speedf1, speedf2;
-  static int32 nutflag = 0;
+  static TLS int32 nutflag = 0;
   double t;
   speedf1 = nutflag & SEFLG_SPEED;
   speedf2 = iflag & SEFLG_SPEED;
@@ -5178,19 +5472,17 @@ int32 FAR PASCAL_CONV swe_fixstar(char *star, double tjd, int32 iflag,
 {
   int i;
   int star_nr = 0;
+  int32 istar;
   AS_BOOL  isnomclat = FALSE;
   size_t cmplen;
   double x[6], xxsv[6], xobs[6], *xpo = NULL;
   char *cpos[20];
   char sstar[SE_MAX_STNAME + 1];
-  char fstar[SE_MAX_STNAME + 1];
-  char s[AS_MAXCH + 20], *sp, *sp2;	/* 20 byte for SE_STARFILE */
+  char s[AS_MAXCH + 20], *sp;	/* 20 byte for SE_STARFILE */
   double ra_s, ra_pm, de_pm, ra, de, t, cosra, cosde, sinra, sinde;
   double ra_h, ra_m, de_d, de_m, de_s;
   char *sde_d;
   double epoch, radv, parall, u;
-  int line = 0;
-  int fline = 0;
   struct plan_data *pedp = &swed.pldat[SEI_EARTH];
   struct plan_data *psdp = &swed.pldat[SEI_SUNBARY];
   struct epsilon *oe = &swed.oec2000;
@@ -5216,11 +5508,9 @@ int32 FAR PASCAL_CONV swe_fixstar(char *star, double tjd, int32 iflag,
    * nutation                               * 
    ******************************************/
   swi_check_nutation(tjd, iflag);
-  if (swed.fixfp == NULL) {
-    if ((swed.fixfp = swi_fopen(SEI_FILE_FIXSTAR, SE_STARFILE, swed.ephepath, serr)) == NULL) {
-      retc = ERR;
-      goto return_err;
-    }
+  if (swed.fixcat.stars == NULL && load_fixstars(serr) != OK) {
+    retc = ERR;
+    goto return_err;
   }
   /******************************************************
    * Star file
@@ -5229,7 +5519,6 @@ int32 FAR PASCAL_CONV swe_fixstar(char *star, double tjd, int32 iflag,
    * All other stars can be accessed by name.
    * Comment lines start with # and are ignored.
    ******************************************************/
-  rewind(swed.fixfp);
   strncpy(sstar, star, SE_MAX_STNAME);
   sstar[SE_MAX_STNAME] = '\0';
   if (*sstar == ',') {
@@ -5251,45 +5540,26 @@ int32 FAR PASCAL_CONV swe_fixstar(char *star, double tjd, int32 iflag,
     retc = ERR;
     goto return_err;
   }
-  while (fgets(s, AS_MAXCH, swed.fixfp) != NULL) {
-    fline++;	
-    if (*s == '#') continue;
-    line++;
-    if (star_nr == line)
-      goto found;
-    else if (star_nr > 0)
-      continue;
-    if ((sp = strchr(s, ',')) == NULL) {
+  if (star_nr > 0) {
+    istar = star_nr <= swed.fixcat.nstars ? star_nr - 1 : -1;
+  } else {
+    istar = fixstar_search(sstar, cmplen, isnomclat);
+    /* a scan of the file would have stopped at a damaged line */
+    if (swed.fixcat.idamaged >= 0 && (istar < 0 || istar > swed.fixcat.idamaged)) {
       if (serr != NULL)
-	sprintf(serr, "star file %s damaged at line %d", SE_STARFILE, fline);
+	sprintf(serr, "star file %s damaged at line %d", SE_STARFILE, 
+		swed.fixcat.stars[swed.fixcat.idamaged].fline);
       retc = ERR;
       goto return_err;
-    } 
-    if (isnomclat) {
-      if (strncmp(sp, sstar, cmplen) == 0)
-        goto found;
-      else
-        continue;
     }
-    *sp = '\0';	/* cut off first field */
-    strncpy(fstar, s, SE_MAX_STNAME);
-    *sp = ',';
-    fstar[SE_MAX_STNAME] = '\0';	/* force termination */
-    swi_right_trim(fstar);
-    i = strlen(fstar);
-    if (i < (int) cmplen)
-      continue;
-    for (sp2 = fstar; *sp2 != '\0'; sp2++) {
-      *sp2 = tolower((int) *sp2);
-    }
-    if (strncmp(fstar, sstar, cmplen) == 0) 
-      goto found;
-  }
-  if (serr != NULL && strlen(star) < AS_MAXCH - 20) 
-    sprintf(serr, "star %s not found", star);
-  retc = ERR;
-  goto return_err;
-  found:
+  }
+  if (istar < 0) {
+    if (serr != NULL && strlen(star) < AS_MAXCH - 20) 
+      sprintf(serr, "star %s not found", star);
+    retc = ERR;
+    goto return_err;
+  }
+  strcpy(s, swed.fixcat.stars[istar].line);
   i = swi_cutstr(s, ",", cpos, 20);
   swi_right_trim(cpos[0]);
   swi_right_trim(cpos[1]);
@@ -5569,6 +5839,376 @@ int32 FAR PASCAL_CONV swe_fixstar_ut(char *star, double tjd_ut, int32 iflag,
   return swe_fixstar(star, tjd_ut + swe_deltat(tjd_ut), iflag, xx, serr);
 }
 
+/**********************************************************
+ * fixed star catalog
+ * SE_STARFILE is read once per thread (swed is thread local) into
+ * swed.fixcat: stars in file order, for lookups by number, sorted
+ * by name and by nomenclature name, for lookups by abbreviation,
+ * a hash of full names, for lookups without a search, and sorted
+ * by longitude, for swe_fixstar_range().
+ * Lookups find the same star as a scan of the file from the top:
+ * the first one in the file whose name starts with the given one.
+ **********************************************************/
+static int fixstar_cmp_name(const void *a, const void *b)
+{
+  struct fixstar_data *stars = swed.fixcat.stars;
+  int32 i = *(int32 *) a, j = *(int32 *) b;
+  int c = strcmp(stars[i].name, stars[j].name);
+  return c != 0 ? c : i - j;
+}
+
+static int fixstar_cmp_nomen(const void *a, const void *b)
+{
+  struct fixstar_data *stars = swed.fixcat.stars;
+  int32 i = *(int32 *) a, j = *(int32 *) b;
+  int c = strcmp(stars[i].nomen, stars[j].nomen);
+  return c != 0 ? c : i - j;
+}
+
+static int fixstar_cmp_lon(const void *a, const void *b)
+{
+  struct fixstar_data *stars = swed.fixcat.stars;
+  int32 i = *(int32 *) a, j = *(int32 *) b;
+  if (stars[i].lon != stars[j].lon)
+    return stars[i].lon < stars[j].lon ? -1 : 1;
+  return i - j;
+}
+
+static uint32 fixstar_hash(char *key, size_t keylen)
+{
+  uint32 h = 2166136261u;	/* FNV-1a */
+  size_t i;
+  for (i = 0; i < keylen; i++)
+    h = (h ^ (unsigned char) key[i]) * 16777619u;
+  return h;
+}
+
+/* first star in the file whose name (or nomenclature name, if the
+ * search string starts with a comma) starts with sstar; -1 if none.
+ * those stars are adjacent in the sorted index. */
+static int32 fixstar_first(char *sstar, size_t cmplen, AS_BOOL isnomclat)
+{
+  struct fixstar_cat *fc = &swed.fixcat;
+  int32 *idx = isnomclat ? fc->bynomen : fc->byname;
+  int32 lo = 0, hi = fc->nvalid, mid, ifound = -1;
+#define FIXSTAR_KEY(i)	(isnomclat ? fc->stars[idx[i]].nomen : fc->stars[idx[i]].name)
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (strcmp(FIXSTAR_KEY(mid), sstar) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  for (; lo < fc->nvalid && strncmp(FIXSTAR_KEY(lo), sstar, cmplen) == 0; lo++) {
+    if (ifound < 0 || idx[lo] < ifound)
+      ifound = idx[lo];
+  }
+#undef FIXSTAR_KEY
+  return ifound;
+}
+
+static int32 fixstar_search(char *sstar, size_t cmplen, AS_BOOL isnomclat)
+{
+  struct fixstar_cat *fc = &swed.fixcat;
+  struct fixstar_key *k;
+  uint32 h = fixstar_hash(sstar, cmplen);
+  for (k = &fc->hash[h & (fc->hashsize - 1)]; k->key != NULL; 
+       k = &fc->hash[++h & (fc->hashsize - 1)]) {
+    if (k->keylen == cmplen && strncmp(k->key, sstar, cmplen) == 0)
+      return k->istar;
+  }
+  return fixstar_first(sstar, cmplen, isnomclat);
+}
+
+static void fixstar_hash_add(char *key, size_t keylen, AS_BOOL isnomclat)
+{
+  struct fixstar_cat *fc = &swed.fixcat;
+  struct fixstar_key *k;
+  char skey[AS_MAXCH];
+  uint32 h = fixstar_hash(key, keylen);
+  if (keylen == 0 || keylen >= AS_MAXCH)
+    return;
+  for (k = &fc->hash[h & (fc->hashsize - 1)]; k->key != NULL; 
+       k = &fc->hash[++h & (fc->hashsize - 1)]) {
+    if (k->keylen == keylen && strncmp(k->key, key, keylen) == 0)
+      return;
+  }
+  strncpy(skey, key, keylen);
+  skey[keylen] = '\0';
+  k->key = key;
+  k->keylen = keylen;
+  k->istar = fixstar_first(skey, keylen, isnomclat);
+}
+
+static void free_fixstars(void)
+{
+  struct fixstar_cat *fc = &swed.fixcat;
+  int32 i;
+  if (fc->stars != NULL) {
+    for (i = 0; i < fc->nstars; i++)
+      free((void *) fc->stars[i].line);
+    free((void *) fc->stars);
+  }
+  if (fc->byname != NULL)
+    free((void *) fc->byname);
+  if (fc->bynomen != NULL)
+    free((void *) fc->bynomen);
+  if (fc->bylon != NULL)
+    free((void *) fc->bylon);
+  if (fc->byfast != NULL)
+    free((void *) fc->byfast);
+  if (fc->hash != NULL)
+    free((void *) fc->hash);
+  memset((void *) fc, 0, sizeof(struct fixstar_cat));
+}
+
+/* reads the star file into swed.fixcat */
+static int load_fixstars(char *serr)
+{
+  struct fixstar_cat *fc = &swed.fixcat;
+  struct fixstar_data *sd;
+  char s[AS_MAXCH], *sp, *cpos[20];
+  int32 i, nalloc = 0, fline = 0;
+  double x[6], eps2000, ra_pm, de_pm, pm, parall;
+  size_t len;
+  free_fixstars();
+  fc->idamaged = -1;
+  if ((swed.fixfp = swi_fopen(SEI_FILE_FIXSTAR, SE_STARFILE, swed.ephepath, serr)) == NULL)
+    return ERR;
+  eps2000 = swi_epsiln(J2000);
+  while (fgets(s, AS_MAXCH, swed.fixfp) != NULL) {
+    fline++;
+    if (*s == '#') continue;
+    if (fc->nstars == nalloc) {
+      nalloc = nalloc == 0 ? 1024 : nalloc * 2;
+      sd = (struct fixstar_data *) realloc((void *) fc->stars, nalloc * sizeof(struct fixstar_data));
+      if (sd == NULL)
+	goto malloc_err;
+      fc->stars = sd;
+    }
+    sd = &fc->stars[fc->nstars];
+    memset((void *) sd, 0, sizeof(struct fixstar_data));
+    sd->fline = fline;
+    fc->nstars++;
+    len = strlen(s);
+    if ((sd->line = (char *) malloc(len + 1)) == NULL)
+      goto malloc_err;
+    strcpy(sd->line, s);
+    if ((sd->nomen = strchr(sd->line, ',')) == NULL) {
+      if (fc->idamaged < 0)
+	fc->idamaged = fc->nstars - 1;
+      continue;
+    }
+    /* name as compared by swe_fixstar() */
+    len = sd->nomen - sd->line;
+    if (len > SE_MAX_STNAME)
+      len = SE_MAX_STNAME;
+    strncpy(sd->name, sd->line, len);
+    sd->name[len] = '\0';
+    swi_right_trim(sd->name);
+    for (sp = sd->name; *sp != '\0'; sp++)
+      *sp = tolower((int) *sp);
+    /* approximate longitude, for range queries */
+    if (swi_cutstr(s, ",", cpos, 20) < 13) {
+      sd->lon = -1;
+      continue;
+    }
+    x[0] = (atof(cpos[5]) / 3600.0 + atof(cpos[4]) / 60.0 + atof(cpos[3])) * 15.0;
+    if (strchr(cpos[6], '-') == NULL)
+      x[1] = atof(cpos[8]) / 3600.0 + atof(cpos[7]) / 60.0 + atof(cpos[6]);
+    else
+      x[1] = -atof(cpos[8]) / 3600.0 - atof(cpos[7]) / 60.0 + atof(cpos[6]);
+    ra_pm = atof(cpos[9]) * 15 / 3600.0 * cos(x[1] * DEGTORAD);
+    de_pm = atof(cpos[10]) / 3600.0;
+    pm = sqrt(ra_pm * ra_pm + de_pm * de_pm);
+    /* radial velocity times parallax, as the space motion of swe_fixstar() */
+    parall = atof(cpos[12]);
+    if (parall > 1)
+      parall = 1 / parall / 3600;
+    else
+      parall /= 3600;
+    sd->rv = atof(cpos[11]) * KM_S_TO_AU_CTY * parall * DEGTORAD;
+    x[0] *= DEGTORAD;
+    x[1] *= DEGTORAD;
+    x[2] = 1;
+    swi_polcart(x, x);
+    if (atof(cpos[2]) == 1950)
+      swi_precess(x, B1950, J_TO_J2000);
+    swi_coortrf(x, x, eps2000);
+    swi_cartpol(x, x);
+    sd->lon = x[0] * RADTODEG;
+    sd->lat = x[1] * RADTODEG;
+    sd->pm = pm;
+    if (!FIXSTAR_IS_FAST(sd)) {
+      if (sd->pm > fc->maxpm)
+	fc->maxpm = sd->pm;
+      if (fabs(sd->rv) > fc->maxrv)
+	fc->maxrv = fabs(sd->rv);
+    }
+  }
+  fclose(swed.fixfp);
+  swed.fixfp = NULL;
+  /* indices */
+  fc->byname = (int32 *) malloc((fc->nstars + 1) * sizeof(int32));
+  fc->bynomen = (int32 *) malloc((fc->nstars + 1) * sizeof(int32));
+  fc->bylon = (int32 *) malloc((fc->nstars + 1) * sizeof(int32));
+  fc->byfast = (int32 *) malloc((fc->nstars + 1) * sizeof(int32));
+  for (fc->hashsize = 64; fc->hashsize < fc->nstars * 4; fc->hashsize *= 2)
+    ;
+  fc->hash = (struct fixstar_key *) calloc((size_t) fc->hashsize, sizeof(struct fixstar_key));
+  if (fc->byname == NULL || fc->bynomen == NULL || fc->bylon == NULL 
+      || fc->byfast == NULL || fc->hash == NULL)
+    goto malloc_err;
+  for (i = 0; i < fc->nstars; i++) {
+    if (fc->stars[i].nomen == NULL)
+      continue;
+    fc->byname[fc->nvalid] = i;
+    fc->bynomen[fc->nvalid] = i;
+    fc->nvalid++;
+  }
+  qsort((void *) fc->byname, (size_t) fc->nvalid, sizeof(int32), fixstar_cmp_name);
+  qsort((void *) fc->bynomen, (size_t) fc->nvalid, sizeof(int32), fixstar_cmp_nomen);
+  for (i = 0; i < fc->nvalid; i++) {
+    sd = &fc->stars[fc->byname[i]];
+    fixstar_hash_add(sd->name, strlen(sd->name), FALSE);
+    /* ",nomenclature name" as it is searched for: trimmed */
+    strncpy(s, sd->nomen, AS_MAXCH - 1);
+    s[AS_MAXCH - 1] = '\0';
+    if ((sp = strchr(s + 1, ',')) != NULL)
+      *sp = '\0';
+    fixstar_hash_add(sd->nomen, strlen(swi_right_trim(s)), TRUE);
+  }
+  /* stars with coordinates by longitude */
+  for (i = 0, len = 0; i < fc->nvalid; i++) {
+    if (fc->stars[fc->byname[i]].lon >= 0)
+      fc->bylon[len++] = fc->byname[i];
+  }
+  fc->nlon = (int32) len;
+  qsort((void *) fc->bylon, len, sizeof(int32), fixstar_cmp_lon);
+  for (i = 0; i < fc->nlon; i++) {
+    if (FIXSTAR_IS_FAST(&fc->stars[fc->bylon[i]]))
+      fc->byfast[fc->nfast++] = fc->bylon[i];
+  }
+  return OK;
+  malloc_err:
+  if (swed.fixfp != NULL) {
+    fclose(swed.fixfp);
+    swed.fixfp = NULL;
+  }
+  free_fixstars();
+  if (serr != NULL)
+    sprintf(serr, "error in malloc() reading star file %s", SE_STARFILE);
+  return ERR;
+}
+
+/* half width of the search around a star: what the precessed J2000 
+ * longitude leaves out of its longitude at t (centuries from J2000). 
+ * nutation, aberration and the motion of the ecliptic move the star by 
+ * up to 0.02 + 0.05 |t| degrees on the sphere, the proper motion pm 
+ * (degrees per century) by |t| pm / (1 - |rv t|), as the star comes 
+ * nearer or goes away at rv (distances per century). that is 1 / cos(lat) 
+ * times more in longitude; lat is the largest the star reaches. 
+ * 180 if the star can be anywhere in longitude. */
+static double fixstar_margin(double t, double lat, double pm, double rv)
+{
+  double d = 1 - fabs(rv * t);
+  if (d <= 0)
+    return 180;
+  pm /= d;
+  lat = fabs(lat) + fabs(t) * (pm + 0.02);
+  if (lat >= 89)
+    return 180;
+  return (0.02 + fabs(t) * (pm + 0.05)) / cos(lat * DEGTORAD);
+}
+
+/* numbers of the stars near ecliptic longitude lon at tjd, by longitude.
+ * the longitudes of the catalog (J2000, at load time) are moved by the
+ * general precession; the search is widened by what that leaves out:
+ * proper motions, the motion of the ecliptic, nutation and aberration.
+ * so it returns candidates, to be computed with swe_fixstar().
+ * most stars share one window, found by a binary search; the few which 
+ * can move by many times more in longitude (FIXSTAR_IS_FAST) get a 
+ * window each. the two are merged by longitude.
+ */
+int32 FAR PASCAL_CONV swe_fixstar_range(double tjd, double lon, double orb, 
+  int32 *stars, int32 nmax, char *serr)
+{
+  struct fixstar_cat *fc = &swed.fixcat;
+  struct fixstar_data *sd;
+  double t, lon0, width, margin, dm = 0, df = 0;
+  int32 lo, hi, mid, i, j, k, n = 0, im = -1, jf = -1;
+  if (serr != NULL)
+    *serr = '\0';
+  if (fc->stars == NULL && load_fixstars(serr) != OK)
+    return ERR;
+  t = (tjd - J2000) / 36525.0;
+  margin = orb + fixstar_margin(t, FIXSTAR_FAST_LAT, fc->maxpm, fc->maxrv);
+  if (margin >= 180) {
+    for (i = 0; i < fc->nlon; i++) {
+      if (n < nmax)
+	stars[n] = fc->bylon[i] + 1;
+      n++;
+    }
+    return n;
+  }
+  /* lon at J2000 */
+  lon = swe_degnorm(lon - (5028.796195 + 1.1054348 * t) * t / 3600.0);
+  lon0 = swe_degnorm(lon - margin);
+  width = 2 * margin;
+  lo = 0;
+  hi = fc->nlon;
+  while (lo < hi) {
+    mid = (lo + hi) / 2;
+    if (fc->stars[fc->bylon[mid]].lon < lon0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  /* fast stars from the opposite longitude on */
+  j = 0;
+  hi = fc->nfast;
+  while (j < hi) {
+    mid = (j + hi) / 2;
+    if (fc->stars[fc->byfast[mid]].lon < swe_degnorm(lon + 180))
+      j = mid + 1;
+    else
+      hi = mid;
+  }
+  /* merge both by the distance from lon, -180 ... 180 */
+  for (i = 0, k = 0; ; ) {
+    while (im < 0 && i < fc->nlon) {
+      sd = &fc->stars[fc->bylon[(lo + i) % fc->nlon]];
+      if (swe_degnorm(sd->lon - lon0) > width)
+	break;
+      if (!FIXSTAR_IS_FAST(sd)) {
+	im = fc->bylon[(lo + i) % fc->nlon];
+	dm = swe_difdeg2n(sd->lon, lon);
+      }
+      i++;
+    }
+    while (jf < 0 && k < fc->nfast) {
+      sd = &fc->stars[fc->byfast[(j + k) % fc->nfast]];
+      df = swe_difdeg2n(sd->lon, lon);
+      if (fabs(df) <= orb + fixstar_margin(t, sd->lat, sd->pm, sd->rv))
+	jf = fc->byfast[(j + k) % fc->nfast];
+      k++;
+    }
+    if (im < 0 && jf < 0)
+      break;
+    if (jf < 0 || (im >= 0 && dm <= df)) {
+      if (n < nmax)
+	stars[n] = im + 1;
+      im = -1;
+    } else {
+      if (n < nmax)
+	stars[n] = jf + 1;
+      jf = -1;
+    }
+    n++;
+  }
+  return n;
+}
+
 #if 0
 int swe_fixstar(char *star, double tjd, int32 iflag, double *xx, char *serr)
 {
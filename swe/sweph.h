@@ -179,6 +179,9 @@
 #define SEI_FILE_REORD  	2
 
 #define SEI_FILE_NMAXPLAN	50
+
+#define SEI_SEGC_DEFAULT	8	/* decoded segments kept per body */
+#define SEI_SEGC_MAX		256
 #define SEI_FILE_EFPOSBEGIN      500
 
 #define SE_FILE_SUFFIX	"se1"
@@ -346,6 +349,14 @@ extern struct epsilon oec2000;
 extern struct epsilon oec;
 */
 
+/* a decoded segment kept for reuse, see swe_set_segment_cache() */
+struct seg_cache {
+  double tseg0, tseg1;	/* start and end jd of segment */
+  double *segp;		/* 3 x ncoe coefficients, after rot_back(); NULL: empty */
+  int neval;		/* how many coefficients to evaluate */
+  uint32 used;		/* stamp of last use, for lru replacement */
+};
+
 struct plan_data {
   /* the following data are read from file only once, immediately after 
    * file has been opened */
@@ -381,6 +392,10 @@ struct plan_data {
 			 * the size is 3 x ncoe */
   int neval;		/* how many coefficients to evaluate. this may
 			 * be less than ncoe */
+  /* recently used segments of this body, flushed when the file changes */
+  struct seg_cache *segc;
+  int nsegc;		/* number of entries in segc */
+  uint32 segc_clock;	/* lru stamp counter */
   /* result of most recent data evaluation for this body: */
   double teval;		/* time for which previous computation was made */
   int32 iephe;            /* which ephemeris was used */
@@ -413,6 +428,8 @@ extern int swi_moshplan(double tjd, int ipli, AS_BOOL do_save, double *xpret, do
 extern int swi_moshplan2(double J, int iplm, double *pobj);
 extern int swi_osc_el_plan(double tjd, double *xp, int ipl, int ipli, double *xearth, double *xsun, char *serr);
 extern FILE *swi_fopen(int ifno, char *fname, char *ephepath, char *serr);
+extern unsigned char *swi_map_file(FILE *fp, long *len);
+extern void swi_unmap_file(unsigned char *p, long len);
 extern double swi_dot_prod_unit(double *x, double *y);
 
 /* nutation */
@@ -440,6 +457,8 @@ struct file_data {
   int32 sweph_denum;     /* DE number of JPL ephemeris, which this file
 			 * is derived from. */
   FILE *fptr;		/* ephemeris file pointer */
+  unsigned char *fmap;	/* memory mapped file image, or NULL */
+  long fmaplen;		/* length of the mapped image */
   double tfstart;       /* file may be used from this date */
   double tfend;         /*      through this date          */
   int32 iflg; 		/* byte reorder flag and little/bigendian flag */
@@ -496,6 +515,52 @@ struct sid_data {
   double t0;
 };
 
+/* a star of the fixed star catalog, see load_fixstars() */
+struct fixstar_data {
+  char *line;		/* record as read from the file */
+  char name[SE_MAX_STNAME + 1];	/* traditional name, trimmed, lower case */
+  char *nomen;		/* in line, at the comma before the nomenclature name */
+  double lon;		/* ecliptic longitude J2000 in degrees, without proper motion */
+  double lat;		/* ecliptic latitude J2000 in degrees */
+  double pm;		/* proper motion, degrees per century */
+  double rv;		/* radial velocity, in distances per century */
+  int32 fline;		/* line number in file */
+};
+
+/* hash entry: a star name or ",nomenclature" name and the star it finds */
+struct fixstar_key {
+  char *key;		/* NULL: empty slot */
+  size_t keylen;
+  int32 istar;
+};
+
+/* stars beyond this ecliptic latitude (degrees), or approaching or 
+ * receding by more than this part of their distance per century, can 
+ * move fast in longitude; swe_fixstar_range() widens the search for 
+ * each of them */
+#define FIXSTAR_FAST_LAT	60
+#define FIXSTAR_FAST_RV		0.01
+#define FIXSTAR_IS_FAST(sd)	(fabs((sd)->lat) > FIXSTAR_FAST_LAT || fabs((sd)->rv) > FIXSTAR_FAST_RV)
+
+/* the fixed star catalog, read from SE_STARFILE once. 
+ * stars are in file order; the index + 1 is the star number. */
+struct fixstar_cat {
+  struct fixstar_data *stars;	/* NULL: not read yet */
+  int32 nstars;
+  int32 *byname;	/* valid stars sorted by name */
+  int32 *bynomen;	/* valid stars sorted by nomenclature name (rest of line) */
+  int32 *bylon;		/* valid stars with coordinates sorted by longitude */
+  int32 *byfast;	/* the ones of them that are FIXSTAR_IS_FAST */
+  int32 nvalid;		/* number of entries in byname and bynomen */
+  int32 nlon;		/* number of entries in bylon */
+  int32 nfast;		/* number of entries in byfast */
+  struct fixstar_key *hash;	/* exact names, for lookups without search */
+  int32 hashsize;	/* a power of 2 */
+  int32 idamaged;	/* first star without a comma, -1: none */
+  double maxpm;		/* largest proper motion, degrees per century, */
+  double maxrv;		/* and radial velocity of the stars not in byfast */
+};
+
 struct swe_data {
   AS_BOOL ephe_path_is_set;
   short jpl_file_is_open;
@@ -527,6 +592,11 @@ struct swe_data {
   double ast_diam;
   int i_saved_planet_name;
   char saved_planet_name[80];
+  int32 segc_size;	/* segments cached per body: 0 = SEI_SEGC_DEFAULT, < 0 = off */
+  int32 segc_hits;	/* segment requests served from the cache */
+  int32 segc_misses;	/* segment requests read from the file */
+  struct fixstar_cat fixcat;	/* fixed stars, replaces reading fixfp per call */
+  double *nut2000a;	/* IAU 2000A series in SoA layout, see swephlib.c */
 };
 
-extern struct swe_data FAR swed;
+extern TLS struct swe_data FAR swed;
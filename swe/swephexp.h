@@ -435,12 +435,34 @@ ext_def( int32 ) swe_fixstar(
 ext_def(int32) swe_fixstar_ut(char *star, double tjd_ut, int32 iflag, 
 	double *xx, char *serr);
 
+/* numbers of the stars near ecliptic longitude lon (degrees, equinox of 
+ * date) at tjd, sorted by longitude; at most nmax are stored in stars. 
+ * returns how many there are, or ERR. candidates: none within orb of 
+ * swe_fixstar() is missing, but some may be farther, stars near the 
+ * ecliptic poles by far. orb >= 180 returns the whole catalog. */
+ext_def(int32) swe_fixstar_range(double tjd, double lon, double orb, 
+	int32 *stars, int32 nmax, char *serr);
+
 /* close Swiss Ephemeris */
 ext_def( void ) swe_close(void);
 
 /* set directory path of ephemeris files */
 ext_def( void ) swe_set_ephe_path(char *path);
 
+/* interpolation table for nutation, obliquity and precession over 
+ * tjd_start ... tjd_end (ET), shared by all threads; step in days 
+ * (0 = 1 day), fname: file to map it from or save it to, or NULL; 
+ * only its header is checked, so it must not be writable by others. 
+ * tjd_end <= tjd_start removes it. see swephlib.c */
+ext_def( int32 ) swe_set_nutation_table(double tjd_start, double tjd_end, 
+	double step, char *fname, char *serr);
+
+/* number of decoded ephemeris segments kept per body (0 = no cache) */
+ext_def( void ) swe_set_segment_cache(int32 nseg);
+
+/* hits and misses of the segment cache of the calling thread */
+ext_def( void ) swe_get_segment_cache_stats(int32 *hits, int32 *misses, int32 reset);
+
 /* set file name of JPL file */
 ext_def( void ) swe_set_jpl_file(char *fname);
 
@@ -66,7 +66,7 @@
 
 /* choose between the following nutation models */
 #define NUT_IAU_1980          FALSE
-#define NUT_IAU_2000A         FALSE   /* very time consuming ! */
+#define NUT_IAU_2000A         FALSE   /* 8 microseconds with AVX2, 67 without */
 #define NUT_IAU_2000B         TRUE  /* fast, but precision of milli-arcsec */
 					 
 /* coordinate transformation */
@@ -107,6 +107,8 @@ extern void swi_force_app_pos_etc();
 /* obliquity of ecliptic */
 extern void swi_check_ecliptic(double tjd);
 extern double swi_epsiln(double J);
+/* obliquity, its sine and cosine from the nutation table, if it covers J */
+extern AS_BOOL swi_nuttab_epsilon(double J, double *e);
 
 /* nutation */
 extern void swi_check_nutation(double tjd, int32 iflag);
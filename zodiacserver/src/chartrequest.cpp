@@ -0,0 +1,124 @@
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDebug>
+#include <Astroprocessor/Output>
+#include "chartrequest.h"
+
+
+/* =========================== CHART REQUEST ======================================== */
+
+QDateTime requestGMT(const QStringList& args)
+{
+    QDateTime dt(QDate(args.at(2).toInt(), args.at(3).toInt(), args.at(4).toInt()),
+                 QTime(args.at(5).toInt(), args.at(6).toInt(), 0));
+    return dt.addSecs(-3600 * args.at(7).toInt());
+}
+
+QVector3D requestLocation(const QStringList& args)
+{
+    return QVector3D(args.at(9).toFloat(), args.at(8).toFloat(), 0);
+}
+
+QString requestLocationName(const QStringList& args)
+{
+    return QString(args.at(10)).replace("_", " ") +
+           "\nlat: " + args.at(8) +
+           "\nlon: " + args.at(9);
+}
+
+A::InputData requestInput(const QStringList& args)
+{
+    A::InputData input;
+    input.GMT      = requestGMT(args);
+    input.location = requestLocation(args);
+    return input;
+}
+
+QSize requestCaptureSize(const QStringList& args)
+{
+    QStringList wh = args.at(15).split("x");
+    if (wh.count() != 2) return QSize();
+    return QSize(wh.at(0).toInt(), wh.at(1).toInt());
+}
+
+bool parseBatchRecord(const QByteArray& line, A::InputData& input, QByteArray& name)
+{
+    QVariantList v;                                  // year month day hour min gmt lat lon [houseSystem zodiac aspectSet]
+    name.clear();
+
+    if (line.startsWith('{'))
+    {
+        QJsonObject o = QJsonDocument::fromJson(line).object();
+        static const char* keys[] = { "a", "m", "d", "h", "min", "gmt", "lat", "lon", "hs", "z", "as" };
+        for (int i = 0; i < 11; i++)
+            if (o.contains(keys[i])) v << o.value(keys[i]).toVariant();
+            else if (i < 8) return false;
+        name = o.value("n").toVariant().toString().toUtf8();
+    }
+    else
+    {
+        foreach (const QByteArray& s, line.split(';'))
+            v << QString::fromUtf8(s.trimmed());
+        if (v.count() < 8) return false;
+    }
+
+    bool ok = true, ret = true;
+    QDate date(v[0].toInt(&ok), v[1].toInt(), v[2].toInt());  ret &= ok;
+    QTime time(v[3].toInt(), v[4].toInt(), 0);
+    double gmt = v[5].toDouble(&ok);                            ret &= ok;
+    double lat = v[6].toDouble(&ok);                            ret &= ok;
+    double lon = v[7].toDouble(&ok);                            ret &= ok;
+    if (!ret || !date.isValid() || !time.isValid()) return false; // e.g. CSV header
+
+    input.GMT = QDateTime(date, time, Qt::UTC).addSecs(-qRound(gmt * 3600));
+    input.location = QVector3D(lon, lat, 0);
+    if (v.count() > 8)  input.houseSystem = v[8].toInt();
+    if (v.count() > 9)  input.zodiac      = v[9].toInt();
+    if (v.count() > 10) input.aspectSet   = v[10].toInt();
+    return true;
+}
+
+bool writeChartJson(const A::Horoscope& scope, const QStringList& args)
+{
+    static const char* params[]  = { "ms", "n", "a", "m", "d", "h", "min", "gmt", "lat", "lon", "ciudad" };
+    static const int paramArgs[] = {  12,   1,   2,   3,   4,   5,   6,     7,     8,     9,     10     };
+
+    QByteArray json;
+    json.reserve(8192);
+    json.append("{\"params\":{");
+    for (int i = 0; i < 11; i++)
+    {
+        if (i) json.append(',');
+        json.append('"');
+        json.append(params[i]);
+        json.append("\":");
+        if (i == 10)
+            A::writeJsonString(json, QString(args.at(paramArgs[i])).replace("_", " "));
+        else
+            A::writeJsonString(json, args.at(paramArgs[i]));   // request fields come from the socket in daemon mode
+    }
+    json.append("},");
+
+    A::writeJson(json, scope);                       // psc, asp, pc
+
+    json.append(",\"jsonHades\":");
+    QFile jsonHades(args.at(16));
+    if(jsonHades.open(QIODevice::ReadOnly)){
+        json.append(jsonHades.readAll());
+    }else{
+        json.append("\"\"");
+    }
+    json.append("}\n");
+
+    QString jsonFileName=QString(args.at(11)).replace("\\", "/");
+    qDebug()<<"Saving json file "<<jsonFileName;
+    QFile jsonFile(jsonFileName);
+    if(!jsonFile.open(QIODevice::WriteOnly)){
+        qDebug()<<"Can't write json file "<<jsonFileName;
+        return false;
+    }
+    jsonFile.write(json);
+    jsonFile.close();
+    return true;
+}
@@ -0,0 +1,28 @@
+#ifndef CHARTREQUEST_H
+#define CHARTREQUEST_H
+
+#include <QStringList>
+#include <QSize>
+#include <Astroprocessor/Data>
+
+
+/* =========================== CHART REQUEST ======================================== */
+
+// Chart requests share the command line layout of zodiac_server (index 0 is the program):
+//   fileName year month day hour min gmt lat lon city jsonLocation ms secs captureLocation resCap jsonHades
+// These helpers don't touch widgets, so they are linked into zodiac_compute as well.
+
+QDateTime    requestGMT           ( const QStringList& args );
+QVector3D    requestLocation      ( const QStringList& args );
+QString      requestLocationName  ( const QStringList& args );
+A::InputData requestInput         ( const QStringList& args );
+QSize        requestCaptureSize   ( const QStringList& args );   // resCap "1280x720"; invalid size if malformed
+
+bool         writeChartJson       ( const A::Horoscope& scope, const QStringList& args );   // writes 'params', 'psc', 'asp', 'pc' into jsonLocation
+
+// Batch record: either a JSON object with the 'params' keys
+//   {"n":"name","a":1975,"m":6,"d":20,"h":22,"min":0,"gmt":-3,"lat":-35.48,"lon":-69.58,"hs":0,"z":0,"as":0}
+// or a CSV row: year;month;day;hour;min;gmt;lat;lon[;houseSystem;zodiac;aspectSet]
+bool         parseBatchRecord     ( const QByteArray& line, A::InputData& input, QByteArray& name );
+
+#endif // CHARTREQUEST_H
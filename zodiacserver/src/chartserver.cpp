@@ -0,0 +1,95 @@
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QApplication>
+#include <QDebug>
+#include "mainwindow.h"
+#include "chartserver.h"
+
+
+/* =========================== CHART SERVER ========================================= */
+
+ChartServer :: ChartServer(MainWindow* window, QObject *parent) : QObject(parent)
+{
+    this->window = window;
+    server = new QLocalServer(this);
+    connect(server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+}
+
+bool ChartServer :: listen(const QString& name)
+{
+    QLocalServer::removeServer(name);             // drop a stale socket left by a crashed daemon
+    if (!server->listen(name))
+    {
+        qDebug() << "ChartServer: can't listen on" << name << ":" << server->errorString();
+        return false;
+    }
+
+    qDebug() << "ChartServer: listening on" << server->fullServerName();
+    return true;
+}
+
+void ChartServer :: newConnection()
+{
+    while (QLocalSocket* socket = server->nextPendingConnection())
+    {
+        connect(socket, SIGNAL(readyRead()),    this,   SLOT(readRequests()));
+        connect(socket, SIGNAL(disconnected()), socket, SLOT(deleteLater()));
+    }
+}
+
+QStringList ChartServer :: splitRequest(const QString& line)
+{
+    QStringList args;
+    QString arg;
+    bool quoted = false, inArg = false;
+
+    for (int i = 0; i < line.size(); i++)
+    {
+        QChar c = line.at(i);
+        if (c == '"')
+        {
+            if (quoted && i + 1 < line.size() && line.at(i + 1) == '"')
+                arg += line.at(++i);                  // "" inside quotes is a literal quote
+            else
+                quoted = !quoted;
+            inArg = true;
+        }
+        else if (c.isSpace() && !quoted)
+        {
+            if (inArg) args << arg;
+            arg.clear();
+            inArg = false;
+        }
+        else
+        {
+            arg += c;
+            inArg = true;
+        }
+    }
+
+    if (inArg) args << arg;
+    return args;
+}
+
+void ChartServer :: readRequests()
+{
+    QLocalSocket* socket = (QLocalSocket*)sender();
+
+    while (socket->canReadLine())
+    {
+        QString line = QString::fromUtf8(socket->readLine()).trimmed();
+        if (line.isEmpty()) continue;
+
+        QStringList args = splitRequest(line);
+        args.prepend(qApp->applicationFilePath());    // keep indexes of qApp->arguments()
+
+        QString reply;
+        if (window->serveRequest(args))
+            reply = "ok " + args.at(11) + "\n";
+        else
+            reply = "error " + line + "\n";
+
+        socket->write(reply.toUtf8());
+        socket->flush();
+    }
+}
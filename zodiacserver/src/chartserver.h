@@ -0,0 +1,46 @@
+#ifndef CHARTSERVER_H
+#define CHARTSERVER_H
+
+#include <QObject>
+#include <QStringList>
+
+class QLocalServer;
+class QLocalSocket;
+class MainWindow;
+
+
+/* =========================== CHART SERVER ========================================= */
+
+// Long-lived request loop: ephemeris, astroprocessor tables and widgets are
+// created once, and every line received on the local socket is served as a
+// separate chart request.
+//
+// Request: one line with the same fields as the command line, without the
+// program name and separated by spaces:
+//   fileName year month day hour min gmt lat lon city jsonLocation ms secs captureLocation resCap jsonHades
+// A field with spaces is quoted as in a shell: "C:/nsp/uda/temp/my capture.png".
+// Inside quotes, "" stands for one literal quote. A line can't hold a newline.
+// captureLocation ending with .svg or .pdf is written as a vector drawing.
+// Reply:   "ok <jsonLocation>" or "error <request>", one line per request.
+
+class ChartServer : public QObject
+{
+    Q_OBJECT
+
+    private:
+        QLocalServer* server;
+        MainWindow* window;
+
+    private slots:
+        void newConnection();
+        void readRequests();
+
+    public:
+        ChartServer(MainWindow* window, QObject *parent = 0);
+
+        static QString defaultName()     { return "zodiac_server"; }
+        static QStringList splitRequest(const QString& line);   // fields of a request line, quotes removed
+        bool listen(const QString& name = defaultName());
+};
+
+#endif // CHARTSERVER_H
@@ -0,0 +1,260 @@
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QLocale>
+#include <QStandardPaths>
+#include <QDebug>
+#include <Astroprocessor/Calc>
+#include <Astroprocessor/Output>
+#include <Astroprocessor/Search>
+#include "chartrequest.h"
+
+// Headless counterpart of zodiac_server: computes the horoscope and writes the
+// same JSON, without QApplication, widgets or a display server. Takes the
+// zodiac_server arguments; secsTimerQuit, captureLocation and resCap are ignored.
+//
+// Batch mode: zodiac_compute --batch [input [output]]
+// Reads one record per line (JSONL or CSV, see parseBatchRecord; '-' or no
+// argument means stdin/stdout) and writes one JSON line per record:
+//   {"i":<line>,"n":"<name>","psc":{...},"asp":{...},"pc":{...}}
+// or {"i":<line>,"error":"bad record"}; 'i' is the input line number.
+// Unlike the zodiac_server json, "asp" has all aspects of the chart's aspect
+// set, not only conjunctions, trines, oppositions and quadratures.
+// Records are read in chunks and each chunk is calculated on all cores into
+// flat charts (A::ChartData); the output keeps the input order. With --fit,
+// planet positions between those years come from the chart precision
+// ephemeris and nutation from a table mapped from the user's cache directory
+// (astro-ephemeris.h).
+//
+// Transits: zodiac_compute --transits|--ingresses record fromYear toYear
+// Searches the transits to the chart of one batch record (its aspect set),
+// or the sign ingresses and house cusp crossings in it, from the start of
+// fromYear to the end of toYear, see astro-search.h. Writes one JSON line
+// per event, sorted by time:
+//   {"jd":<UT>,"e":"enter|exact|leave","b":<body>,"n":<natal>,"a":<aspect>}
+//   {"jd":<UT>,"e":"station","b":<body>,"r":true|false}     (turns retrograde)
+//   {"jd":<UT>,"e":"ingress","b":<body>,"s":<sign entered>}
+//   {"jd":<UT>,"e":"cusp","b":<body>,"h":<house entered>}
+
+struct BatchRecord
+{
+    int line;
+    QByteArray name;
+    int input;                                  // index into the chunk inputs, -1 if the record is bad
+};
+
+static int writeChunk(const QList<BatchRecord>& records, const QList<A::InputData>& inputs,
+                      QVector<A::ChartData>& charts, QIODevice& out)
+{
+    if (records.isEmpty()) return 0;
+
+    A::calculateCharts(inputs, charts);         // parallel; flat charts, reused from chunk to chunk
+    QByteArray json;
+    int failed = 0;
+
+    foreach (const BatchRecord& r, records)
+    {
+        json.clear();
+        json.append("{\"i\":").append(QByteArray::number(r.line)).append(',');
+
+        if (r.input >= 0)
+        {
+            if (!r.name.isEmpty())
+            {
+                json.append("\"n\":");
+                A::writeJsonString(json, QString::fromUtf8(r.name));
+                json.append(',');
+            }
+            A::writeJson(json, charts.at(r.input), true);
+        }
+        else
+        {
+            json.append("\"error\":\"bad record\"");
+            failed++;
+        }
+
+        json.append("}\n");
+        out.write(json);
+    }
+
+    return failed;
+}
+
+static int runBatch(QIODevice& in, QIODevice& out)
+{
+    const int chunkSize = 1024;
+    QList<BatchRecord> records;
+    QList<A::InputData> inputs;
+    QVector<A::ChartData> charts;
+    A::InputData input;
+    QByteArray line, name;
+    int i = 0, failed = 0;
+
+    while (!(line = in.readLine()).isEmpty())              // atEnd() is unreliable on pipes
+    {
+        line = line.trimmed();
+        i++;
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        input = A::InputData();
+        bool ok = parseBatchRecord(line, input, name);
+        if (!ok && i == 1 && !line.startsWith('{')) continue; // CSV header
+
+        BatchRecord r = { i, name, ok ? inputs.count() : -1 };
+        records << r;
+        if (ok) inputs << input;
+
+        if (records.count() == chunkSize)
+        {
+            failed += writeChunk(records, inputs, charts, out);
+            records.clear();
+            inputs.clear();
+        }
+    }
+
+    failed += writeChunk(records, inputs, charts, out);
+    return failed ? 2 : 0;
+}
+
+static int batch(const QStringList& args)
+{
+    QFile in, out;
+    bool ok;
+
+    if (args.size() > 2 && args.at(2) != "-")
+    {
+        in.setFileName(args.at(2));
+        ok = in.open(QIODevice::ReadOnly);
+    }
+    else
+        ok = in.open(stdin, QIODevice::ReadOnly);
+
+    if (args.size() > 3 && args.at(3) != "-")
+    {
+        out.setFileName(args.at(3));
+        ok = ok && out.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+    else
+        ok = ok && out.open(stdout, QIODevice::WriteOnly);
+
+    if (!ok)
+    {
+        qWarning() << "zodiac_compute: can't open batch input/output";
+        return 1;
+    }
+
+    return runBatch(in, out);
+}
+
+static double yearStart(int year)
+{
+    return A::julianDay(QDateTime(QDate(year, 1, 1), QTime(0, 0), Qt::UTC));
+}
+
+static int transits(const QStringList& args, bool ingresses)
+{
+    static const char* types[] = { "enter", "exact", "leave", "station", "ingress", "cusp" };
+    A::InputData input;
+    QByteArray name;
+
+    if (args.size() != 5 || !parseBatchRecord(args.at(2).toUtf8(), input, name))
+    {
+        qWarning() << "zodiac_compute: bad transit request";
+        return 1;
+    }
+
+    A::Horoscope natal = A::calculateAll(input);
+    double from = yearStart(args.at(3).toInt());
+    double to   = yearStart(args.at(4).toInt() + 1);
+    A::TransitEventList events = ingresses ? A::findIngresses(natal, from, to)
+                                           : A::findTransits(natal, from, to, A::getAspectSet(input.aspectSet));
+    QFile out;
+    out.open(stdout, QIODevice::WriteOnly);
+    QByteArray json;
+
+    foreach (const A::TransitEvent& e, events)
+    {
+        json.clear();
+        json.append("{\"jd\":").append(QByteArray::number(e.jd, 'f', 6))
+            .append(",\"e\":\"").append(types[e.type])
+            .append("\",\"b\":").append(QByteArray::number(e.body));
+
+        switch (e.type)
+        {
+            case A::Transit_Station:
+                json.append(",\"r\":").append(e.retrograde ? "true" : "false");
+                break;
+            case A::Transit_Ingress:
+                json.append(",\"s\":").append(QByteArray::number(e.sign));
+                break;
+            case A::Transit_Cusp:
+                json.append(",\"h\":").append(QByteArray::number(e.house));
+                break;
+            default:
+                json.append(",\"n\":").append(QByteArray::number(e.natal))
+                    .append(",\"a\":").append(QByteArray::number(e.aspect->id));
+        }
+
+        json.append("}\n");
+        out.write(json);
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    a.setApplicationName("Zodiac");
+    a.setApplicationVersion("v0.7.1 (build 2014-06-30)");
+
+    bool batchMode   = a.arguments().size() > 1 && a.arguments().at(1) == "--batch";
+    bool transitMode = a.arguments().size() > 1 && (a.arguments().at(1) == "--transits" ||
+                                                    a.arguments().at(1) == "--ingresses");
+
+    if (!batchMode && !transitMode && a.arguments().size() != 17)
+     {
+      qWarning() << "Usage:" << a.arguments().at(0)
+                 << "fileName year month day hour min gmt lat lon city jsonLocation ms secs captureLocation resCap jsonHades";
+      qWarning() << "      " << a.arguments().at(0) << "--batch [input.jsonl|input.csv|-] [output.jsonl|-] [--fit fromYear toYear]";
+      qWarning() << "      " << a.arguments().at(0) << "--transits|--ingresses record fromYear toYear";
+      return 1;
+     }
+
+    QStringList args = a.arguments();
+    int fitFrom = 0, fitTo = 0;
+    int fit = args.indexOf("--fit");
+    if (batchMode && fit > 1 && fit + 2 < args.size())
+    {
+        fitFrom = args.at(fit + 1).toInt();
+        fitTo   = args.at(fit + 2).toInt();
+        args.erase(args.begin() + fit, args.begin() + fit + 3);
+    }
+    for (int i = 2; batchMode && i < args.size(); i++)       // resolve before changing dir
+        if (args[i] != "-") args[i] = QFileInfo(args[i]).absoluteFilePath();
+
+    QDir::setCurrent(a.applicationDirPath());
+    QString lang = QLocale::system().name().contains("RU", Qt::CaseInsensitive) ? "ru" : "en";
+    A::load(lang);
+
+    if (batchMode && fitTo > fitFrom)                        // chart precision positions, see astro-ephemeris.h
+    {
+        // the table is mapped without checking its values, so not from a directory others can write
+        QString cache = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+        QDir().mkpath(cache);
+        A::setNutationTable(yearStart(fitFrom), yearStart(fitTo + 1),
+                            cache.isEmpty() ? QString() : QDir(cache).filePath("zodiac-nutation.tab"));
+        A::buildChartEphemeris(yearStart(fitFrom), yearStart(fitTo + 1));
+        A::EphemerisError e = A::chartEphemerisError(200);
+        qWarning() << "zodiac_compute: fitted ephemeris, max error lon" << e.lon << "\" lat" << e.lat << "\"";
+    }
+
+    if (batchMode)
+        return batch(args);
+    if (transitMode)
+        return transits(args, args.at(1) == "--ingresses");
+
+    A::Horoscope scope = A::calculateAll(requestInput(a.arguments()));
+    return writeChartJson(scope, a.arguments()) ? 0 : 1;
+}
@@ -29,6 +29,10 @@ void emptyOutput(QtMsgType type, const QMessageLogContext &context, const QStrin
 
 int main(int argc, char *argv[])
 {
+    for (int i = 1; i < argc; i++)               // daemon renders charts without showing any window
+        if (!qstrcmp(argv[i], "--daemon") && qgetenv("QT_QPA_PLATFORM").isEmpty())
+            qputenv("QT_QPA_PLATFORM", "offscreen");
+
     QApplication a(argc, argv);
     a.setApplicationName("Zodiac");
     a.setApplicationVersion("v0.7.1 (build 2014-06-30)");
@@ -63,6 +67,7 @@ int main(int argc, char *argv[])
     cssfile.open  ( QIODevice::ReadOnly | QIODevice::Text );
     w.setStyleSheet  ( cssfile.readAll() );
 
-    w.show();
+    if (!a.arguments().contains("--daemon"))
+      w.show();
     return a.exec();
 }
@@ -22,6 +22,8 @@
 //#include "../planets/src/planets.h"
 //#include "../astroqmlviewv2.h"
 #include "../details/src/details.h"
+#include "chartserver.h"
+#include "chartrequest.h"
 #include "mainwindow.h"
 
 
@@ -819,6 +821,9 @@ void FilesBar :: openFileAsSecond(QString name)
 
 MainWindow :: MainWindow(QWidget *parent) : QMainWindow(parent), Customizable()
 {
+    chartServer = 0;
+    captureScene = 0;
+    captureCompression = -1;
     HelpWidget* help   = new HelpWidget("text/" + A::usedLanguage(), this);
 
     filesBar           = new FilesBar(this);
@@ -895,86 +900,43 @@ MainWindow :: MainWindow(QWidget *parent) : QMainWindow(parent), Customizable()
 
     /*===================ZODIAC SERVER ====================*/
 
+    //Modo daemon: zodiac_server --daemon [serverName]
+    //Cada línea recibida en el socket local es un pedido con los mismos argumentos (ver ChartServer)
+
     //Argumentos esperados
     //fileName 1975 6 20 22 00 -3 -35.484462 -69.5797495 Malargue_Mendoza /home/nextsigner/data.json 15321321 10 "/home/nextsigner/Escritorio/capture.png"
     //fileName año mes día hora minutos gmt lat lon ciudad jsonLocation ms secsTimerQuit captureLocation resCap5120x2880
+    //secsTimerQuit se ignora: el proceso termina en cuanto escribe el json y la captura, con código 1 si alguno falla
+    //captureLocation .svg o .pdf: gráfico vectorial, resCap solo fija la proporción y el tamaño por defecto
 
     //Utilizado en programación Windows 7
     //fileName 1975 6 20 23 00 -3 -35.484462 -69.5797495 Malargue_Mendoza C:/nsp/uda/temp/data.json 15321321 10 "C:/nsp/uda/temp/capture.png" 1280x720 1280x720
 
     qDebug()<<"Count args: "<<qApp->arguments().size();
 
-    if(qApp->applicationFilePath().indexOf("zodiac_server")>0&&(qApp->arguments().size()==2||qApp->arguments().size()==17)){
+    if(qApp->arguments().contains("--daemon")){
+        startDaemon();
+    }else if(qApp->applicationFilePath().indexOf("zodiac_server")>0&&(qApp->arguments().size()==2||qApp->arguments().size()==17)){
         qDebug()<<"Se toman argumentos "<<qApp->arguments();
         QString fileName;
         fileName.append(qApp->arguments().at(1));
         AstroFile nf;
         if(qApp->arguments().size()==17){
-            QStringList slResCap=qApp->arguments().at(15).split("x");
-            if(slResCap.length()!=2){
+            QSize captureSize=requestCaptureSize(qApp->arguments());
+            if(!captureSize.isValid()){
                 qDebug()<<"Error de resolución de captura.";
-                this->close();
+                QTimer::singleShot(0, this, SLOT(quitWithError()));
+                return;
             }
-            int xCnWidth=slResCap.at(0).toInt();
-            int xCnHeight=slResCap.at(1).toInt();
-            xCn=new QWidget();
-            xCn->setObjectName("xcn");
-            xCn->setStyleSheet("#xcn{background-color: red}");
-            xCn->setMinimumWidth(xCnWidth);
-            xCn->setMinimumHeight(xCnHeight);
-            xCn->setMaximumWidth(xCnWidth);
-            xCn->setMaximumHeight(xCnHeight);
-            xCn->setGeometry(0,0, xCnWidth, xCnHeight);
-            xCn->show();
-            QVBoxLayout* layoutCn = new QVBoxLayout(xCn);
-            layoutCn->setSpacing(0);
-            layoutCn->setMargin(0);
-            layoutCn->addWidget(astroWidget);
-
-            //Timer Capture
-            timerCapture = new QTimer(this);
-            connect(timerCapture, SIGNAL(timeout()), this, SLOT(capture()));
-            timerCapture->start(1000);
-
-            //Timer Quit
-            timerQuit = new QTimer(this);
-            connect(timerQuit, SIGNAL(timeout()), qApp, SLOT(quit()));
-            timerQuit->start(qApp->arguments().at(13).toInt()*1000);
 
             QFile docDat(fileName);
             if(!docDat.exists()){
                 nf.setName(fileName);
-                QDate d(qApp->arguments().at(2).toInt(), qApp->arguments().at(3).toInt(), qApp->arguments().at(4).toInt());
-                QTime t(qApp->arguments().at(5).toInt(), qApp->arguments().at(6).toInt(), 0);
-
-                QDateTime dt;
-                dt.setDate(d);
-                dt.setTime(t);
-                int sec;
-                if(qApp->arguments().at(7).toInt()<0){
-                    sec=(3600*abs(qApp->arguments().at(7).toInt()));
-                }else{
-                    sec=0-(3600*qApp->arguments().at(7).toInt());
-                }
-
-                QString locale_st_HH = QLocale("en_EN").toString(dt, "yyyy MMMM dd HH.mm.ss zzz ap");
-                qDebug()<<"Time: "<<locale_st_HH;
-                dt=dt.addSecs(sec);
-                locale_st_HH = QLocale("en_EN").toString(dt, "yyyy MMMM dd HH.mm.ss zzz ap");
-                //qDebug()<<"Time: "<<locale_st_HH;
-                nf.setGMT(dt);
+                nf.setGMT(requestGMT(qApp->arguments()));
                 nf.setTimezone(qApp->arguments().at(7).toInt());
                 qDebug()<<"NF Time Zone: "<<nf.getTimezone();
-                nf.setLocation(QVector3D(qApp->arguments().at(9).toFloat(), qApp->arguments().at(8).toFloat(),0));
-                QString nomciu;
-                nomciu.append(qApp->arguments().at(10));
-                QString ln;
-                ln.append(nomciu.replace("_", " "));
-                ln.append("\nlat: ");
-                ln.append(qApp->arguments().at(8));
-                ln.append("\nlon: ");
-                ln.append(qApp->arguments().at(9));
-                nf.setLocationName(ln);
+                nf.setLocation(requestLocation(qApp->arguments()));
+                nf.setLocationName(requestLocationName(qApp->arguments()));
                 nf.save();
             }else{
                 nf.load(fileName);
@@ -993,223 +955,12 @@ MainWindow :: MainWindow(QWidget *parent) : QMainWindow(parent), Customizable()
 
             //filesBar->currentFiles().at(0)->get
 
-            //Casas
-            QString params;
-            params.append("\"params\":{\n");
-
-            params.append("\"ms\":\"");
-            params.append(qApp->arguments().at(12));
-            params.append("\",");
-
-            params.append("\"n\":\"");
-            params.append(qApp->arguments().at(1));
-            params.append("\",");
-
-            params.append("\"a\":\"");
-            params.append(qApp->arguments().at(2));
-            params.append("\",");
-
-            params.append("\"m\":\"");
-            params.append(qApp->arguments().at(3));
-            params.append("\",");
-
-            params.append("\"d\":\"");
-            params.append(qApp->arguments().at(4));
-            params.append("\",");
-
-            params.append("\"h\":\"");
-            params.append(qApp->arguments().at(5));
-            params.append("\",");
-
-            params.append("\"min\":\"");
-            params.append(qApp->arguments().at(6));
-            params.append("\",");
-
-            params.append("\"gmt\":\"");
-            params.append(qApp->arguments().at(7));
-            params.append("\",");
-
-            params.append("\"lat\":\"");
-            params.append(qApp->arguments().at(8));
-            params.append("\",");
-
-            params.append("\"lon\":\"");
-            params.append(qApp->arguments().at(9));
-            params.append("\",");
-
-            params.append("\"ciudad\":\"");
-            params.append(QString(qApp->arguments().at(10)).replace("_", " "));
-            params.append("\"");
-
-            params.append("}\n");
-
-            //Planetas en signo y casa
-            QString psc;
-            psc.append("\"psc\":{\n");
-            for (int i=0;i<filesBar->currentFiles().at(0)->horoscope().planets.count();i++) {
-                //qDebug()<<"------- "<<A::describePlanet(filesBar->currentFiles().at(0)->horoscope().planets.value(i), filesBar->currentFiles().at(0)->horoscope().zodiac);
-                QString d=A::describePlanet(filesBar->currentFiles().at(0)->horoscope().planets.value(i), filesBar->currentFiles().at(0)->horoscope().zodiac);
-                QString item;
-                //qDebug()<<"["<<d<<"]\n\n";
-                QStringList m0=d.replace(" Pole", "").replace("         ", "@").replace("         ", "@").replace("        ", "@").replace("       ", "@").replace("      ", "@").replace("     ", "@").replace("    ", "@").replace("   ", "@").replace("  ", "@").replace(" ", "@").replace(".", "").replace("@@@@", "@").replace("@@@", "@").replace("@@", "@").split("@");
-
-                if(i!=0){
-                    item.append(",");
-                }
-
-                qDebug()<<"-----"<<m0.at(0)<<"-------\n\n";
-                item.append("\"");
-                item.append(m0.at(0));
-                item.append("\":{");
-
-                item.append("\"g\":");
-                item.append(QString::number(m0.at(1).toInt()));
-                item.append(",");
-
-                item.append("\"m\":");
-                item.append(QString::number(m0.at(3).toInt()));
-
-                item.append(",");
-                item.append("\"s\":\"");
-                item.append(m0.at(2));
-                item.append("\"");
-
-                QString h="-1";
-                if(m0.at(4)=="I"){h="1";}
-                if(m0.at(4)=="II"){h="2";}
-                if(m0.at(4)=="III"){h="3";}
-                if(m0.at(4)=="IV"){h="4";}
-                if(m0.at(4)=="V"){h="5";}
-                if(m0.at(4)=="VI"){h="6";}
-                if(m0.at(4)=="VII"){h="7";}
-                if(m0.at(4)=="VIII"){h="8";}
-                if(m0.at(4)=="IX"){h="9";}
-                if(m0.at(4)=="X"){h="10";}
-                if(m0.at(4)=="XI"){h="11";}
-                if(m0.at(4)=="XII"){h="12";}
-
-                item.append(",");
-                item.append("\"h\":");
-                item.append(h);
-                item.append("");
-
-                item.append(",");
-                item.append("\"rh\":\"");
-                item.append(m0.at(4));
-                item.append("\"");
-
-                item.append("}\n");
-                psc.append(item);
-            }
-            psc.append("}\n");
-
-
-            //Casas
-            QString pc;
-            pc.append("\"pc\":{\n");
-            QStringList h0=A::describeHouses(filesBar->currentFiles().at(0)->horoscope().houses, filesBar->currentFiles().at(0)->horoscope().zodiac).split("\n");
-            for (int i=1;i<h0.length();i++) {
-                qDebug()<<h0.at(i);
-                QString d;
-                d.append(h0.at(i));
-                QStringList m0=d.replace("\"", "").replace("         ", "@").replace("         ", "@").replace("        ", "@").replace("       ", "@").replace("      ", "@").replace("     ", "@").replace("    ", "@").replace("   ", "@").replace("  ", "@").replace(" ", "@").replace(".", "").replace("\n", "").split("@");
-                qDebug()<<"--->"<<m0;
-                QString item;
-                if(i!=1){
-                    item.append(",");
-                }
-
-                item.append("\"h");
-                item.append(QString::number(i));
-                item.append("\":{");
-
-                item.append("\"s\":\"");
-                item.append(m0.at(m0.length()-2));
-                item.append("\",");
-
-                item.append("\"g\":");
-                item.append(QString::number(m0.at(m0.length()-3).toInt()));
-                item.append(",");
-
-                item.append("\"m\":");
-                item.append(QString::number(m0.at(m0.length()-1).toInt()));
-                //item.append("\"");
-
-                item.append("}\n");
-                pc.append(item);
-            }
-            pc.append("}\n");
-
-            //Aspectos
-            int vasp=0;
-            QString asp;
-            asp.append("\"asp\":{\n");
-            for (int i=0;i<filesBar->currentFiles().at(0)->horoscope().aspects.count();i++) {
-                QString a1=A::describeAspect(filesBar->currentFiles().at(0)->horoscope().aspects.value(i));
-                qDebug()<<"--->"<<a1<<"<---";
-                QStringList m0=a1.split(" ");
-                QString item;
-                QString tipo=m0.at(0);
-                if(tipo.contains("Trine")||tipo.contains("Conjunction")||tipo.contains("Opposition")||tipo.contains("Quadrature")){
-                    if(vasp!=0){
-                        item.append(",");
-                    }
-                    item.append("\"asp");
-                    item.append(QString::number(vasp));
-                    item.append("\":{");
-
-                    item.append("\"t\":\"");
-                    item.append(tipo);
-                    item.append("\",");
-
-                    item.append("\"p\":\"");
-                    item.append(m0.at(1));
-                    item.append("\"");
-
-                    item.append("}\n");
-                    asp.append(item);
-                    vasp++;
-                }
-            }
-             asp.append("}\n");
-
-
-
-
-             //qDebug()<<A::describePower(filesBar->currentFiles().at(0)->horoscope().sun, filesBar->currentFiles().at(0)->horoscope());
-
-            //qDebug()<<A::describePlanet(filesBar->currentFiles().at(0)->horoscope().planets.value(i), filesBar->currentFiles().at(0)->horoscope().zodiac);
-            //resultado.append(nz.describe(nf->horoscope(), (nf.getZodiac()::Article)articles));
-
-            //qDebug()<<nz.describe(nf->horoscope(), (filesBar->currentFiles().at(0).getZodiac()::Article)articles);
-
-
-            QString extraData="";
-            QFile jsonHades(qApp->arguments().at(16));
-            if(jsonHades.open(QIODevice::ReadOnly)){
-                extraData.append(jsonHades.readAll());
-            }else{
-                extraData.append("\"\"");
-            }
-            QString json;
-            json.append("{\n");
-            json.append(params);
-            json.append(",");
-            json.append(psc.toLower());
-            json.append(",");
-            json.append(asp);
-            json.append(",");
-            json.append(pc.toLower());
-            json.append(",\"jsonHades\":");
-            json.append(extraData);
-            json.append("}\n");
-            //qDebug()<<json;
-            QString jsonFileName=QString(qApp->arguments().at(11)).replace("\\", "/");
-            qDebug()<<"Saving json file "<<jsonFileName;
-            QFile jsonFile(jsonFileName);
-            jsonFile.open(QIODevice::WriteOnly);
-            jsonFile.write(json.toUtf8());
-            jsonFile.close();
+            bool ok = writeChartJson(filesBar->currentFiles().at(0)->horoscope(), qApp->arguments());
+            ok = capture(qApp->arguments().at(14), captureSize) && ok;
+            if(ok)
+                QTimer::singleShot(0, qApp, SLOT(quit()));
+            else
+                QTimer::singleShot(0, this, SLOT(quitWithError()));
         }
         if(qApp->arguments().size()==2){
             qDebug()<<"Abriendo "<<qApp->arguments().at(1)<<" ...";
@@ -1249,11 +1000,73 @@ MainWindow :: MainWindow(QWidget *parent) : QMainWindow(parent), Customizable()
     }
 }
 
-void MainWindow::capture()
+MainWindow :: ~MainWindow()
+{
+    delete captureScene;
+}
+
+void MainWindow::startDaemon()
+{
+    QString name = ChartServer::defaultName();
+    int i = qApp->arguments().indexOf("--daemon");
+    if (i + 1 < qApp->arguments().size())
+        name = qApp->arguments().at(i + 1);
+
+    filesBar->addNewFile();                          // the single file reused by every request
+    chartServer = new ChartServer(this, this);
+    if (!chartServer->listen(name))
+        QTimer::singleShot(0, qApp, SLOT(quit()));
+}
+
+void MainWindow::quitWithError()
+{
+    qApp->exit(1);
+}
+
+bool MainWindow::serveRequest(const QStringList& args)
+{
+    if (args.size() != 17)
+    {
+        qDebug() << "Argumentos insuficientes:" << args.size();
+        return false;
+    }
+
+    QSize captureSize = requestCaptureSize(args);
+    if (!captureSize.isValid())
+    {
+        qDebug() << "Error de resolución de captura.";
+        return false;
+    }
+
+    AstroFile* file = filesBar->currentFiles().at(0);
+    file->suspendUpdate();                           // recalculate once, after all members are set
+    file->setName(args.at(1));
+    file->setGMT(requestGMT(args));
+    file->setTimezone(args.at(7).toInt());
+    file->setLocation(requestLocation(args));
+    file->setLocationName(requestLocationName(args));
+    file->clearUnsavedState();
+    file->resumeUpdate();
+
+    if (!writeChartJson(file->horoscope(), args))
+        return false;
+    return capture(args.at(14), captureSize);
+}
+
+bool MainWindow::capture(const QString& fileName, const QSize& size)
 {
-    QPixmap pixmap(xCn->geometry().size());
-    xCn->render(&pixmap, QPoint(0, 0), QRegion(0,0,xCn->geometry().width(), xCn->geometry().height()));
-    pixmap.save(qApp->arguments().at(14));
+    if (!captureScene)
+        captureScene = new ChartScene;               // the next charts only move planets, cusps and aspects
+
+    captureScene->setStyle(ChartStyle(astroWidget->currentSettings()));   // "Circle/..." settings of the chart slide
+    captureScene->setHoroscopes(QList<A::Horoscope>() << filesBar->currentFiles().at(0)->horoscope());
+    captureScene->build();
+    if (!captureScene->save(fileName, size, QByteArray(), captureCompression))   // png, svg, pdf... by the suffix
+    {
+        qDebug() << "Can't save capture" << fileName;
+        return false;
+    }
+    return true;
 }
 
 void MainWindow        :: contextMenu         ( QPoint p )
@@ -1320,6 +1133,7 @@ AppSettings MainWindow :: defaultSettings     ( )
     s.setValue ( "Window/Geometry",         0 );
     s.setValue ( "Window/State",            0 );
     s.setValue ( "askToSave",           false );
+    s.setValue ( "Capture/pngCompression", -1 );
     return s;
 }
 
@@ -1330,6 +1144,7 @@ AppSettings MainWindow :: currentSettings     ( )
     s.setValue ( "Window/Geometry",      this->saveGeometry() );
     s.setValue ( "Window/State",         this->saveState() );
     s.setValue ( "askToSave",            askToSave );
+    s.setValue ( "Capture/pngCompression", captureCompression );
     return s;
 }
 
@@ -1339,6 +1154,7 @@ void MainWindow        :: applySettings       ( const AppSettings& s )
     this -> restoreGeometry   ( s.value ( "Window/Geometry" ).toByteArray() );
     this -> restoreState      ( s.value ( "Window/State" ).toByteArray() );
     askToSave = s.value ( "askToSave" ).toBool();
+    captureCompression = qBound(-1, s.value ( "Capture/pngCompression" ).toInt(), 9);
 }
 
 void MainWindow        :: setupSettingsEditor ( AppSettingsEditor* ed )
@@ -18,6 +18,8 @@ class QActionGroup;
 class AstroFileEditor;
 class GeoSearchWidget;
 class QComboBox;
+class ChartServer;
+class ChartScene;
 
 /* =========================== ASTRO FILE INFO ====================================== */
 
@@ -206,8 +208,11 @@ class MainWindow : public QMainWindow, public Customizable
         QMenu*         panelsMenu;
 
         //Zodiac Server
-        QTimer *timerQuit;
-        QTimer *timerCapture;
+        ChartServer *chartServer;
+        ChartScene *captureScene;                        // reused by all captures
+        int captureCompression;                          // zlib level of png captures, -1 for default
+
+        void startDaemon();
 
         void addToolBarActions();
         QAction* createActionForPanel(QWidget* w/*, const QIcon &icon*/);
@@ -219,9 +224,7 @@ class MainWindow : public QMainWindow, public Customizable
         void showAbout();
         void gotoUrl(QString url = "");
         void contextMenu(QPoint);
-
-        //Zodiac Server
-        void capture();
+        void quitWithError();                            // exit code 1 once the event loop runs
 
     protected:
         AppSettings defaultSettings ();      // 'Customizable' class implementations
@@ -233,9 +236,11 @@ class MainWindow : public QMainWindow, public Customizable
 
     public:
         MainWindow(QWidget *parent = 0);
+        ~MainWindow();
 
         //Zodiac Server
-        QWidget *xCn;
+        bool serveRequest(const QStringList& args);     // args are laid out as qApp->arguments()
+        bool capture(const QString& fileName, const QSize& size);   // renders the current chart into an image, SVG or PDF
 
 };
 
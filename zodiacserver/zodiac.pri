@@ -4,11 +4,15 @@ TRANSLATIONS = ../bin/i18n/zodiac_ru.ts \
 SOURCES += src/main.cpp \
        src/mainwindow.cpp \
     src/help.cpp \
-    src/slidewidget.cpp
+    src/slidewidget.cpp \
+    src/chartserver.cpp \
+    src/chartrequest.cpp
 
 HEADERS  += src/mainwindow.h \
     src/help.h \
-    src/slidewidget.h
+    src/slidewidget.h \
+    src/chartserver.h \
+    src/chartrequest.h
 
 ## win icon, etc
 win32: RC_FILE = app.rc
@@ -0,0 +1,34 @@
+# Compute-only build of the chart JSON: swe and the non-GUI part of astroprocessor.
+# QtGui is linked for QVector2D/QVector3D only; no widgets and no display are needed.
+QT -= widgets
+QT += gui
+CONFIG += console
+CONFIG -= app_bundle
+DESTDIR = $$_PRO_FILE_PWD_/../bin
+TARGET = zodiac_compute
+TEMPLATE = app
+
+VPATH += ../swe
+
+include(../swe/swe.pri)
+
+SOURCES += ../astroprocessor/src/astro-calc.cpp \
+    ../astroprocessor/src/astro-data.cpp \
+    ../astroprocessor/src/astro-ephemeris.cpp \
+    ../astroprocessor/src/astro-output.cpp \
+    ../astroprocessor/src/astro-search.cpp \
+    ../astroprocessor/src/astro-time.cpp \
+    ../astroprocessor/src/csvreader.cpp \
+    src/chartrequest.cpp \
+    src/compute.cpp
+
+HEADERS += ../astroprocessor/src/astro-calc.h \
+    ../astroprocessor/src/astro-data.h \
+    ../astroprocessor/src/astro-ephemeris.h \
+    ../astroprocessor/src/astro-output.h \
+    ../astroprocessor/src/astro-search.h \
+    ../astroprocessor/src/astro-time.h \
+    ../astroprocessor/src/csvreader.h \
+    src/chartrequest.h
+
+INCLUDEPATH += ../astroprocessor/include/ ../swe